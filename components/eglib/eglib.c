@@ -26,6 +26,7 @@ void eglib_Init(
 		eglib->drawing.color_index[i].r = 0;
 		eglib->drawing.color_index[i].g = 0;
 		eglib->drawing.color_index[i].b = 0;
+		eglib->drawing.pixel_index[i] = eglib_ColorToPixel(eglib->drawing.color_index[i]);
 	}
 
 	eglib->hal.driver->init(eglib);
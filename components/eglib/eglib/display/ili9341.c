@@ -1,6 +1,7 @@
 #include "ili9341.h"
 #include "frame_buffer.h"
 #include <esp_log.h>
+#include <string.h>
 
 
 //
@@ -200,6 +201,27 @@ static void set_interface_pixel_format(eglib_t *eglib) {
 	eglib_SendDataByte(eglib, interface_pixel_format);
 }
 
+// Address window and write pointer of the display memory as last set, in
+// display memory rows (+34). Writes that continue the window skip CASET and
+// RASET, writes starting at the pointer go on with WRITE_MEMORY_CONTINUE.
+// Kept for one display, the eglib_t last written to.
+static struct {
+	eglib_t *eglib;
+	bool valid;             // x_start .. y
+	bool madctl_valid;
+	uint8_t madctl;
+	uint16_t x_start, x_end;
+	uint16_t y_start, y_end;
+	uint16_t x, y;          // write pointer
+} window;
+
+// whenever other commands may have disturbed the window or pointer
+static void window_invalidate(void) {
+	window.valid = false;
+	window.madctl_valid = false;
+}
+
+// sent only if changed, the configuration may have been changed since
 static void set_memory_data_access_control(eglib_t *eglib) {
 	ili9341_config_t *display_config;
 	uint8_t memory_data_access_control;
@@ -248,20 +270,30 @@ static void set_memory_data_access_control(eglib_t *eglib) {
 			memory_data_access_control |= ILI9341_MEMORY_DATA_ACCESS_CONTROL_DISPLAY_DATA_LATCH_DATA_ORDER_LCD_REFRESH_RIGHT_TO_LEFT;
 			break;
 	}
+	if(window.eglib != eglib) {
+		window_invalidate();
+		window.eglib = eglib;
+	}
+	if(window.madctl_valid && window.madctl == memory_data_access_control)
+		return;
 	eglib_SendCommandByte(eglib, ILI9341_MEMORY_DATA_ACCESS_CONTROL);
 	eglib_SendDataByte(eglib, memory_data_access_control);
+	window.valid = false;
+	window.madctl_valid = true;
+	window.madctl = memory_data_access_control;
 }
 
 static void set_column_address(eglib_t *eglib, uint16_t x_start, uint16_t x_end) {
 	uint8_t buff[4];
 	// ESP_LOGI("ili", "set_column_address %d %d", x_start, x_end );
-	set_memory_data_access_control(eglib);
 	eglib_SendCommandByte(eglib, ILI9341_COLUMN_ADDRESS_SET);
 	buff[0] = (x_start&0xFF00)>>8;
 	buff[1] = x_start&0xFF;
 	buff[2] = (x_end&0xFF00)>>8;
 	buff[3] = x_end&0xFF;
 	eglib_SendData(eglib, buff, sizeof(buff));
+	window.x_start = x_start;
+	window.x_end = x_end;
 }
 
 static void set_row_address(eglib_t *eglib, uint16_t y_start, uint16_t y_end) {
@@ -273,6 +305,50 @@ static void set_row_address(eglib_t *eglib, uint16_t y_start, uint16_t y_end) {
 	buff[2] = (y_end&0xFF00)>>8;
 	buff[3] = y_end&0xFF;
 	eglib_SendData(eglib, buff, sizeof(buff));
+	window.y_start = y_start;
+	window.y_end = y_end;
+}
+
+// Has the next pixels sent written from x, y on, in rows of width pixels
+// for more than one row, at least width pixels for one. Rows are set up to
+// the bottom of the display memory, so that the next row can continue.
+static void begin_write(eglib_t *eglib, uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+	ili9341_config_t *display_config;
+	uint16_t x_end = x + width - 1;
+	uint16_t y_end = y + height - 1;
+	bool columns, rows;
+
+	display_config = eglib_GetDisplayConfig(eglib);
+
+	set_memory_data_access_control(eglib);
+	if(height == 1)
+		columns = window.valid && window.x_start <= x && x_end <= window.x_end;
+	else
+		columns = window.valid && window.x_start == x && window.x_end == x_end;
+	rows = window.valid && y_end <= window.y_end;
+	if(columns && rows && window.x == x && window.y == y) {
+		eglib_SendCommandByte(eglib, ILI9341_WRITE_MEMORY_CONTINUE);
+		return;
+	}
+	if(!columns || window.x_start != x)
+		set_column_address(eglib, x, x_end);
+	if(!rows || window.y_start != y)
+		set_row_address(eglib, y, y_end > display_config->height - 1 ? y_end : display_config->height - 1);
+	eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
+	window.valid = true;
+	window.x = x;
+	window.y = y;
+}
+
+// the write pointer after pixels more were sent
+static void end_write(uint32_t pixels) {
+	uint32_t width = window.x_end - window.x_start + 1;
+	uint32_t pos = window.x - window.x_start + pixels;
+
+	window.x = window.x_start + pos % width;
+	window.y += pos / width;
+	if(window.y > window.y_end)   // wrapped to the top of the window
+		window.valid = false;
 }
 
 static uint8_t get_bits_per_pixel(eglib_t *eglib) {
@@ -322,19 +398,18 @@ static void clear_memory(eglib_t *eglib) {
 	memory_size = (display_config->width * display_config->height * get_bits_per_pixel(eglib)) / 8;
 	ESP_LOGI("ili9341", "memory size: %d %d %d %d", memory_size, display_config->width, display_config->height, get_bits_per_pixel(eglib) );
 
-	set_column_address(eglib, 0, display_config->width - 1);
-	set_row_address(eglib, 0, display_config->height - 1);
-	eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
+	begin_write(eglib, 0, 0, display_config->width, display_config->height);
 	uint8_t buf[256] = { 255 };
 	for(uint32_t addr=0 ; addr < memory_size ; addr+= 256 ){
 		ESP_LOGI("ili9341", "addr: %d", addr );
 		eglib_SendData(eglib, buf, 256 );
 	}
+	window_invalidate();
 }
 
-static void send_pixel(eglib_t *eglib, color_t color) {
+// color as sent to the display memory, returns the bytes used
+static uint8_t encode_pixel(eglib_t *eglib, color_t color, uint8_t *buff) {
 	ili9341_config_t *display_config;
-	uint8_t buff[3];
 
 	display_config = eglib_GetDisplayConfig(eglib);
 
@@ -343,29 +418,64 @@ static void send_pixel(eglib_t *eglib, color_t color) {
 			buff[0] = color.r & 0xf0;
 			buff[0] |= (color.g & 0xf0) >> 4;
 			buff[1] = color.b & 0xf0;
-			for(uint8_t i=0 ; i < 2 ; i++)
-				eglib_SendDataByte(eglib, buff[i]);
-			break;
+			return 2;
 		case ILI9341_COLOR_16_BIT:
 			buff[0] = color.r & 0xf8;
 			buff[0] |= color.g >> 5;
 			buff[1] = (color.g >> 2) << 5;
 			buff[1] |= color.b >> 3;
-			for(uint8_t i=0 ; i < 2 ; i++)
-				eglib_SendDataByte(eglib, buff[i]);
-			break;
+			return 2;
 		case ILI9341_COLOR_18_BIT:
 			buff[0] = color.r & ~0x03;
 			buff[1] = color.g & ~0x03;
 			buff[2] = color.b & ~0x03;
-			for(uint8_t i=0 ; i < 3 ; i++)
-				eglib_SendDataByte(eglib, buff[i]);
-			break;
+			return 3;
 		default:
 			while(true);
 	}
 }
 
+static void send_pixel(eglib_t *eglib, color_t color) {
+	uint8_t buff[3];
+
+	eglib_SendData(eglib, buff, encode_pixel(eglib, color, buff));
+}
+
+//
+// Spans
+//
+
+// Solid runs are sent from a line of one color, in one transfer per
+// ILI9341_SPAN_PIXELS instead of one per byte. The line is filled up
+// as far as needed and kept until the color changes.
+#define ILI9341_SPAN_PIXELS 320
+
+static uint8_t span[ILI9341_SPAN_PIXELS * 3];
+static uint8_t span_pixel[3];
+static uint8_t span_bytes = 0;    // per pixel, 0 if span is empty
+static uint16_t span_filled = 0;  // pixels
+
+static void send_span(eglib_t *eglib, color_t color, uint32_t count) {
+	uint8_t buff[3];
+	uint8_t bytes;
+
+	bytes = encode_pixel(eglib, color, buff);
+	if(bytes != span_bytes || memcmp(buff, span_pixel, bytes)) {
+		memcpy(span_pixel, buff, bytes);
+		span_bytes = bytes;
+		span_filled = 0;
+	}
+	uint32_t fill = count < ILI9341_SPAN_PIXELS ? count : ILI9341_SPAN_PIXELS;
+	for( ; span_filled < fill ; span_filled++)
+		memcpy(span + span_filled * bytes, buff, bytes);
+
+	while(count) {
+		uint32_t n = count < ILI9341_SPAN_PIXELS ? count : ILI9341_SPAN_PIXELS;
+		eglib_SendData(eglib, span, n * bytes);
+		count -= n;
+	}
+}
+
 //
 // Display
 //
@@ -476,6 +586,10 @@ void lcd_Initial(void)
 */
 
 static void init(eglib_t *eglib) {
+	window_invalidate();
+	if(get_bytes_per_pixel(eglib) != sizeof(pixel_t))
+		ESP_LOGE("ILI9341", "%d bytes per pixel, buffers have %d (EGLIB_RGB565)", get_bytes_per_pixel(eglib), (int)sizeof(pixel_t));
+
 	// Hardware reset
 	eglib_SetReset(eglib, 0);
 	eglib_DelayMs(eglib, ILI9341_RESX_PULSE_MS);
@@ -627,11 +741,13 @@ static void init(eglib_t *eglib) {
 	eglib_SendCommandByte(eglib, ILI9341_DISPLAY_ON );
 
 	eglib_CommEnd(eglib);
+	window_invalidate();
 
 	ESP_LOGI("ili", "init()");
 };
 
 static void sleep_in(eglib_t *eglib) {
+	window_invalidate();
 	eglib_CommBegin(eglib);
 	eglib_SendCommandByte(eglib, ILI9341_SLEEP_IN);
 	eglib_CommEnd(eglib);
@@ -639,6 +755,7 @@ static void sleep_in(eglib_t *eglib) {
 };
 
 static void sleep_out(eglib_t *eglib) {
+	window_invalidate();
 	eglib_CommBegin(eglib);
 	eglib_SendCommandByte(eglib, ILI9341_SLEEP_OUT);
 	eglib_CommEnd(eglib);
@@ -684,12 +801,9 @@ static void draw_pixel_color(
 	eglib_CommBegin(eglib);
 	y+=34;
 
-	set_column_address(eglib, x, x);
-	set_row_address(eglib, y, y);
-
-	eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
-
+	begin_write(eglib, x, y, 1, 1);
 	send_pixel(eglib, color);
+	end_write(1);
 
 	eglib_CommEnd(eglib);
 };
@@ -703,60 +817,33 @@ static void draw_line(
 	color_t (*get_next_color)(eglib_t *eglib)
 ) {
 	// ESP_LOGI("ili DL","x:%d y:%d dir:%d len:%d", x, y, direction, length );
+	if(length <= 0)
+		return;
 	eglib_CommBegin(eglib);
 	y+=34;
 	if(direction == DISPLAY_LINE_DIRECTION_RIGHT) {
 		// ESP_LOGI("DL","x:%d y:%d RIGHT %d", x, y, length  );
-		set_column_address(eglib, x, x + length );
-		set_row_address(eglib, y, y );
+		begin_write(eglib, x, y, length, 1);
 	}
 	else if(direction == DISPLAY_LINE_DIRECTION_DOWN) {
 		// ESP_LOGI("DL","x:%d y:%d DOWN %d", x, y, length  );
-		set_column_address(eglib, x, x );
-		set_row_address(eglib, y, y+length );
+		begin_write(eglib, x, y, 1, length);
 	}
 	else if(direction == DISPLAY_LINE_DIRECTION_UP) {
 		// ESP_LOGI("DL","x:%d y:%d UP %d", x, y, length  );
-		set_column_address(eglib, x, x );
-		set_row_address(eglib, y-length, y );
+		begin_write(eglib, x, y-length, 1, length);
 	}
 	else if(direction == DISPLAY_LINE_DIRECTION_LEFT) {
 		// ESP_LOGI("DL","x:%d y:%d LEFT %d", x, y, length );
-		set_column_address(eglib, x-length, x );  // fake right direction
-		set_row_address(eglib, y, y );
+		begin_write(eglib, x-length, y, length, 1);  // fake right direction
 	}
 	else{
 		ESP_LOGW("draw_line","draw_line method not implemented");
+		eglib_CommEnd(eglib);
+		return;
 	}
-	eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
-	color_t color = eglib->drawing.color_index[0];
-	int len_pix=get_bytes_per_pixel(eglib);  // max 3
-	uint8_t buf[4] = { 0,0,0,0 };
-	ili9341_config_t *display_config = eglib_GetDisplayConfig(eglib);
-	switch(display_config->color) {
-	case ILI9341_COLOR_12_BIT:
-		buf[0] = color.r & 0xf0;
-		buf[0] |= (color.g & 0xf0) >> 4;
-		buf[1] = color.b & 0xf0;
-		break;
-	case ILI9341_COLOR_16_BIT:
-		buf[0] = color.r & 0xf8;
-		buf[0] |= color.g >> 5;
-		buf[1] = (color.g >> 2) << 5;
-		buf[1] |= color.b >> 3;
-		break;
-	case ILI9341_COLOR_18_BIT:
-		buf[0] = color.r & ~0x03;
-		buf[1] = color.g & ~0x03;
-		buf[2] = color.b & ~0x03;
-		break;
-	default:
-		while(true);
-	}
-	for( int i=0; i<length; i++ ){
-		for(int i=0;i < len_pix; i++)
-			eglib_SendDataByte(eglib, buf[i]);
-	}
+	send_span(eglib, eglib->drawing.color_index[0], length);
+	end_write(length);
 	eglib_CommEnd(eglib);
 }
 
@@ -771,12 +858,13 @@ static void send_buffer(
 	display_config = eglib_GetDisplayConfig(eglib);
 	// if((uint32_t)x * get_bits_per_pixel(eglib) % 8)
 	//	x -= 1;
+	if(width <= 0 || height <= 0)
+		return;
 	eglib_CommBegin(eglib);
 	y+=34;
-    set_column_address(eglib, x, x + width -1);
-    set_row_address(eglib, y-height -1, y );
-    eglib_SendCommandByte(eglib, ILI9341_MEMORY_WRITE);
-    eglib_SendData( eglib, buffer, width*height*get_bytes_per_pixel(eglib) );
+    begin_write(eglib, x, y-height -1, width, height);
+    eglib_SendData( eglib, buffer, width*height*sizeof(pixel_t) );
+    end_write(width*height);
 	eglib_CommEnd(eglib);
 }
 
@@ -791,6 +879,7 @@ static bool refresh(eglib_t *eglib) {
 void set_scroll_margins( eglib_t *eglib, coordinate_t top, coordinate_t bottom ){
 	ili9341_config_t *display_config = eglib_GetDisplayConfig(eglib);
 	if (top + bottom <= display_config->height ) {
+		window_invalidate();
 		eglib_CommBegin(eglib);
 		uint16_t middle = display_config->height - top -bottom;
 		uint8_t data[6];
@@ -810,6 +899,7 @@ void set_scroll_margins( eglib_t *eglib, coordinate_t top, coordinate_t bottom )
  *   scroll display by the number of row lines as given
  */
 void scroll( eglib_t *eglib, coordinate_t lines ){
+	window_invalidate();
 	eglib_CommBegin(eglib);
 	eglib_SendCommandByte(eglib, ILI9341_VERTICAL_SCROLL_START_ADDRESS_OF_RAM );
 	uint8_t data[2];
@@ -0,0 +1,285 @@
+#include "tile.h"
+#include "../hal/four_wire_spi/none.h"
+
+//
+// Helpers
+//
+
+static void measure(
+	tile_config_t *config,
+	coordinate_t x0, coordinate_t y0,
+	coordinate_t x1, coordinate_t y1
+) {
+	if(x0 < config->x_start)
+		config->x_start = x0;
+	if(x1 > config->x_end)
+		config->x_end = x1;
+	if(y0 < config->y_start)
+		config->y_start = y0;
+	if(y1 > config->y_end)
+		config->y_end = y1;
+}
+
+// horizontal run of n pixels from x, y, clipped to the window
+static void put_span(
+	tile_config_t *config,
+	coordinate_t x, coordinate_t y,
+	coordinate_t n, pixel_t pixel
+) {
+	if(n <= 0)
+		return;
+	if(config->measure) {
+		measure(config, x, y, x + n - 1, y);
+		return;
+	}
+	if(y < config->y || y >= config->y + config->height)
+		return;
+	if(x < config->x) {
+		n -= config->x - x;
+		x = config->x;
+	}
+	if(x + n > config->x + config->width)
+		n = config->x + config->width - x;
+	pixel_t *p = config->buffer + (y - config->y) * config->width + (x - config->x);
+	while(n-- > 0)
+		*p++ = pixel;
+}
+
+//
+// Display
+//
+
+static void init(eglib_t *eglib) {
+	(void)eglib;
+}
+
+static void sleep_in(eglib_t *eglib) {
+	(void)eglib;
+}
+
+static void sleep_out(eglib_t *eglib) {
+	(void)eglib;
+}
+
+static void get_dimension(
+	eglib_t *eglib,
+	coordinate_t *width, coordinate_t *height
+) {
+	tile_config_t *config;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	config->display->display.driver->get_dimension(config->display, width, height);
+}
+
+static void get_pixel_format(eglib_t *eglib, enum pixel_format_t *pixel_format) {
+	(void)eglib;
+#if EGLIB_RGB565
+	*pixel_format = PIXEL_FORMAT_16BIT_RGB;
+#else
+	*pixel_format = PIXEL_FORMAT_24BIT_RGB;
+#endif
+}
+
+static void draw_pixel_color(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y, color_t color
+) {
+	put_span(eglib_GetDisplayConfig(eglib), x, y, 1, eglib_ColorToPixel(color));
+}
+
+// length pixels in color index 0, placed as by the ILI9341 driver
+static void draw_line(
+	eglib_t *eglib,
+	coordinate_t x,
+	coordinate_t y,
+	enum display_line_direction_t direction,
+	coordinate_t length,
+	color_t (*get_next_color)(eglib_t *eglib)
+) {
+	tile_config_t *config;
+	pixel_t pixel;
+
+	(void)get_next_color;
+	config = eglib_GetDisplayConfig(eglib);
+	pixel = eglib->drawing.pixel_index[0];
+
+	switch(direction) {
+		case DISPLAY_LINE_DIRECTION_RIGHT:
+			put_span(config, x, y, length, pixel);
+			break;
+		case DISPLAY_LINE_DIRECTION_LEFT:
+			put_span(config, x - length, y, length, pixel);
+			break;
+		case DISPLAY_LINE_DIRECTION_DOWN:
+			for(coordinate_t i=0 ; i < length ; i++)
+				put_span(config, x, y + i, 1, pixel);
+			break;
+		case DISPLAY_LINE_DIRECTION_UP:
+			for(coordinate_t i=0 ; i < length ; i++)
+				put_span(config, x, y - length + i, 1, pixel);
+			break;
+	}
+}
+
+// width * height pixels, the first row at y - height - 1 as by the ILI9341 driver
+static void send_buffer(
+	eglib_t *eglib,
+	void *buffer_ptr,
+	coordinate_t x, coordinate_t y,
+	coordinate_t width, coordinate_t height
+) {
+	tile_config_t *config;
+	pixel_t *buffer = (pixel_t *)buffer_ptr;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	y -= height + 1;
+	if(config->measure) {
+		measure(config, x, y, x + width - 1, y + height - 1);
+		return;
+	}
+	for(coordinate_t v=0 ; v < height ; v++) {
+		coordinate_t row = y + v;
+		if(row < config->y || row >= config->y + config->height)
+			continue;
+		pixel_t *p = config->buffer + (row - config->y) * config->width;
+		for(coordinate_t u=0 ; u < width ; u++) {
+			coordinate_t col = x + u;
+			if(col >= config->x && col < config->x + config->width)
+				p[col - config->x] = buffer[v * width + u];
+		}
+	}
+}
+
+static bool refresh(eglib_t *eglib) {
+	(void)eglib;
+	return false;
+}
+
+static void set_scroll_margins(eglib_t *eglib, coordinate_t top, coordinate_t bottom) {
+	(void)eglib;
+	(void)top;
+	(void)bottom;
+}
+
+static void scroll(eglib_t *eglib, coordinate_t lines) {
+	(void)eglib;
+	(void)lines;
+}
+
+static const display_t tile = {
+	.comm = {
+		.four_wire_spi = NULL,
+		.i2c = NULL,
+		.parallel_8_bit_8080 = NULL,
+	},
+	.init = init,
+	.sleep_in = sleep_in,
+	.sleep_out = sleep_out,
+	.get_dimension = get_dimension,
+	.get_pixel_format = get_pixel_format,
+	.draw_pixel_color = draw_pixel_color,
+	.draw_line = draw_line,
+	.send_buffer = send_buffer,
+	.refresh = refresh,
+	.set_scroll_margins = set_scroll_margins,
+	.scroll = scroll
+};
+
+//
+// Extra
+//
+
+void eglib_Init_Tile(
+	eglib_t *eglib,
+	tile_config_t *config,
+	eglib_t *display,
+	pixel_t *buffer,
+	uint32_t pixels
+) {
+	config->display = display;
+	config->buffer = buffer;
+	config->pixels = pixels;
+	config->x = config->y = 0;
+	config->width = config->height = 0;
+	config->measure = false;
+
+	eglib_Init(
+		eglib,
+		&four_wire_spi_none, NULL,
+		&tile, config
+	);
+}
+
+void tile_SetWindow(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y,
+	coordinate_t width, coordinate_t height
+) {
+	tile_config_t *config;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	if((uint32_t)width * height > config->pixels)
+		height = config->pixels / width;
+	config->x = x;
+	config->y = y;
+	config->width = width;
+	config->height = height;
+}
+
+void tile_Fill(eglib_t *eglib, color_t color) {
+	tile_config_t *config;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	pixel_t pixel = eglib_ColorToPixel(color);
+	pixel_t *p = config->buffer;
+	for(uint32_t n = (uint32_t)config->width * config->height ; n-- ; )
+		*p++ = pixel;
+}
+
+// the ILI9341 driver writes rows y - height - 1 .. y
+void tile_Send(eglib_t *eglib) {
+	tile_config_t *config;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	if(!config->width || !config->height)
+		return;
+	config->display->display.driver->send_buffer(
+		config->display,
+		config->buffer,
+		config->x, config->y + config->height + 1,
+		config->width, config->height
+	);
+}
+
+void tile_BeginMeasure(eglib_t *eglib) {
+	tile_config_t *config;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	config->measure = true;
+	config->x_start = config->y_start = 0x7fff;
+	config->x_end = config->y_end = -0x8000;
+}
+
+bool tile_EndMeasure(
+	eglib_t *eglib,
+	coordinate_t *x_start, coordinate_t *y_start,
+	coordinate_t *x_end, coordinate_t *y_end
+) {
+	tile_config_t *config;
+
+	config = eglib_GetDisplayConfig(eglib);
+
+	config->measure = false;
+	*x_start = config->x_start;
+	*y_start = config->y_start;
+	*x_end = config->x_end;
+	*y_end = config->y_end;
+
+	return config->x_start <= config->x_end;
+}
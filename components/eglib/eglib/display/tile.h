@@ -0,0 +1,89 @@
+#ifndef EGLIB_DISPLAY_TILE_H
+#define EGLIB_DISPLAY_TILE_H
+
+#include "../hal.h"
+#include "../../eglib.h"
+#include "../display.h"
+
+/**
+ * Configuration
+ * =============
+ */
+
+/**
+ * Configuration for the tile display: a small buffer of pixels as sent to the
+ * display (:c:type:`pixel_t`), standing in for a
+ * window of another display, e.g. a few lines of an ILI9341.
+ *
+ * Everything drawn to the tile uses the coordinates, dimension and clipping of
+ * the display behind it, pixels outside the window are dropped. Lines and
+ * buffers are placed as the ILI9341 driver places them, so a tile sent with
+ * :c:func:`tile_Send` shows what drawing directly would have shown.
+ *
+ * :c:func:`eglib_Init_Tile` populates the values here.
+ */
+typedef struct {
+	eglib_t *display;
+	pixel_t *buffer;
+	uint32_t pixels;
+	coordinate_t x;
+	coordinate_t y;
+	coordinate_t width;
+	coordinate_t height;
+	bool measure;
+	coordinate_t x_start;
+	coordinate_t x_end;
+	coordinate_t y_start;
+	coordinate_t y_end;
+} tile_config_t;
+
+/**
+ * Functions
+ * =========
+ *
+ * These functions can be used exclusively with :c:type:`eglib_t` initialized
+ * for a tile.
+ */
+
+/**
+ * Initializes ``eglib`` to draw into ``buffer`` of ``pixels`` pixels, standing
+ * in for a window of the already initialized ``display``.
+ */
+void eglib_Init_Tile(
+	eglib_t *eglib,
+	tile_config_t *config,
+	eglib_t *display,
+	pixel_t *buffer,
+	uint32_t pixels
+);
+
+/**
+ * Moves the tile to the given window, ``width * height`` must not exceed the
+ * pixels of the buffer. The buffer content is undefined afterwards.
+ */
+void tile_SetWindow(
+	eglib_t *eglib,
+	coordinate_t x, coordinate_t y,
+	coordinate_t width, coordinate_t height
+);
+
+/** Fills the whole window with ``color``. */
+void tile_Fill(eglib_t *eglib, color_t color);
+
+/** Sends the window to the display memory, in one transfer. */
+void tile_Send(eglib_t *eglib);
+
+/**
+ * Starts measuring: until :c:func:`tile_EndMeasure` nothing is written, only
+ * the bounding box of everything drawn on the whole display is kept.
+ */
+void tile_BeginMeasure(eglib_t *eglib);
+
+/** Bounding box drawn since :c:func:`tile_BeginMeasure`, inclusive, ``false`` if empty. */
+bool tile_EndMeasure(
+	eglib_t *eglib,
+	coordinate_t *x_start, coordinate_t *y_start,
+	coordinate_t *x_end, coordinate_t *y_end
+);
+
+#endif
@@ -65,6 +65,7 @@ void eglib_SetIndexColor(
   eglib->drawing.color_index[idx].r = r;
   eglib->drawing.color_index[idx].g = g;
   eglib->drawing.color_index[idx].b = b;
+  eglib->drawing.pixel_index[idx] = eglib_ColorToPixel(eglib->drawing.color_index[idx]);
 }
 
 //
@@ -953,48 +954,22 @@ static inline bool get_bit2( const struct glyph_t *g, uint16_t x, uint16_t y) {
 */
 
 
-static void eglib_draw_circle_section(eglib_t *eglib, int16_t x, int16_t y, int16_t x0, int16_t y0, uint8_t option) PG_NOINLINE;
+static void eglib_draw_circle_octant(eglib_t *eglib, int16_t x0, int16_t y0, int16_t rad, int8_t sx, int8_t sy, bool steep) PG_NOINLINE;
 
-static void eglib_draw_circle_section(eglib_t *eglib, int16_t x, int16_t y, int16_t x0, int16_t y0, uint8_t option)
-{
-    /* upper right */
-    if ( option & EGLIB_DRAW_UPPER_RIGHT )
-    {
-      eglib_DrawPixel(eglib, x0 + x, y0 - y);
-      eglib_DrawPixel(eglib, x0 + y, y0 - x);
-    }
-    
-    /* upper left */
-    if ( option & EGLIB_DRAW_UPPER_LEFT )
-    {
-      eglib_DrawPixel(eglib, x0 - x, y0 - y);
-      eglib_DrawPixel(eglib, x0 - y, y0 - x);
-    }
-    
-    /* lower right */
-    if ( option & EGLIB_DRAW_LOWER_RIGHT )
-    {
-      eglib_DrawPixel(eglib, x0 + x, y0 + y);
-      eglib_DrawPixel(eglib, x0 + y, y0 + x);
-    }
-    
-    /* lower left */
-    if ( option & EGLIB_DRAW_LOWER_LEFT )
-    {
-      eglib_DrawPixel(eglib, x0 - x, y0 + y);
-      eglib_DrawPixel(eglib, x0 - y, y0 + x);
-    }
-}
-
-
-
-void eglib_DrawCircle(eglib_t *eglib, int16_t x0, int16_t y0, int16_t rad, uint8_t option)
+/*
+ * One octant of the circle, the points (x0 + sx*x, y0 + sy*y), or swapped
+ * (x0 + sx*y, y0 + sy*x) if steep, for x from 0 to where x meets y. Points
+ * sharing y are drawn as one horizontal or vertical run, so that the display
+ * sets its address window once per run instead of once per pixel.
+ */
+static void eglib_draw_circle_octant(eglib_t *eglib, int16_t x0, int16_t y0, int16_t rad, int8_t sx, int8_t sy, bool steep)
 {
     int16_t f;
     int16_t ddF_x;
     int16_t ddF_y;
     int16_t x;
     int16_t y;
+    int16_t start;
 
     f = 1;
     f -= rad;
@@ -1004,13 +979,24 @@ void eglib_DrawCircle(eglib_t *eglib, int16_t x0, int16_t y0, int16_t rad, uint8
     ddF_y *= 2;
     x = 0;
     y = rad;
+    start = 0;
 
-    eglib_draw_circle_section(eglib, x, y, x0, y0, option);
-    
-    while ( x < y )
+    for(;;)
     {
-      if (f >= 0) 
+      bool last = !(x < y);
+      if ( last || f >= 0 )
       {
+        /* run of x from start to x at y */
+        int16_t along = (steep ? sy : sx) > 0 ? start : -x;
+        if ( steep ) {
+          eglib_DrawVLine(eglib, x0 + sx*y, y0 + along, x - start + 1);
+        }
+        else {
+          eglib_DrawHLine(eglib, x0 + along, y0 + sy*y, x - start + 1);
+        }
+        if ( last )
+          break;
+        start = x + 1;
         y--;
         ddF_y += 2;
         f += ddF_y;
@@ -1018,8 +1004,37 @@ void eglib_DrawCircle(eglib_t *eglib, int16_t x0, int16_t y0, int16_t rad, uint8
       x++;
       ddF_x += 2;
       f += ddF_x;
+    }
+}
 
-      eglib_draw_circle_section(eglib, x, y, x0, y0, option);    
+void eglib_DrawCircle(eglib_t *eglib, int16_t x0, int16_t y0, int16_t rad, uint8_t option)
+{
+    /* upper right */
+    if ( option & EGLIB_DRAW_UPPER_RIGHT )
+    {
+      eglib_draw_circle_octant(eglib, x0, y0, rad, 1, -1, false);
+      eglib_draw_circle_octant(eglib, x0, y0, rad, 1, -1, true);
+    }
+
+    /* upper left */
+    if ( option & EGLIB_DRAW_UPPER_LEFT )
+    {
+      eglib_draw_circle_octant(eglib, x0, y0, rad, -1, -1, false);
+      eglib_draw_circle_octant(eglib, x0, y0, rad, -1, -1, true);
+    }
+
+    /* lower right */
+    if ( option & EGLIB_DRAW_LOWER_RIGHT )
+    {
+      eglib_draw_circle_octant(eglib, x0, y0, rad, 1, 1, false);
+      eglib_draw_circle_octant(eglib, x0, y0, rad, 1, 1, true);
+    }
+
+    /* lower left */
+    if ( option & EGLIB_DRAW_LOWER_LEFT )
+    {
+      eglib_draw_circle_octant(eglib, x0, y0, rad, -1, 1, false);
+      eglib_draw_circle_octant(eglib, x0, y0, rad, -1, 1, true);
     }
 }
 
@@ -1193,12 +1208,76 @@ struct font_t {
 };
 */
 
-#define MAX 400
+// Glyphs as sent, rows first_row .. height-1 of advance pixels each, in the
+// colors they were drawn with
+static struct {
+	const struct font_t *font;
+	const struct glyph_t *glyph;
+	pixel_t fg, bg;
+	int16_t first_row;
+	uint32_t used;   // glyph_clock when drawn last, 0 if empty
+	pixel_t pixels[EGLIB_GLYPH_PIXELS];
+} glyph_cache[EGLIB_GLYPH_CACHE];
+static uint32_t glyph_clock = 0;
+static pixel_t glyph_scratch[EGLIB_GLYPH_PIXELS];   // clipped glyphs
+uint32_t eglib_glyph_hits = 0;
+uint32_t eglib_glyph_misses = 0;
+
+static inline bool same_pixel(pixel_t a, pixel_t b) {
+	return memcmp(&a, &b, sizeof(pixel_t)) == 0;
+}
+
+// rows v0 .. v0+rows-1, columns u0 .. u0+cols-1 of the glyph into buffer,
+// the glyph's rows starting at row head
+static void render_glyph(eglib_t *eglib, const struct glyph_t *glyph, int head, int u0, int cols, int v0, int rows, pixel_t *buffer) {
+	pixel_t fg = eglib->drawing.pixel_index[0];
+	pixel_t bg = eglib->drawing.pixel_index[1];
+
+	for(int v1 = v0; v1 < v0 + rows; v1++) {
+		int v = v1 - head;  // read glyph from right row
+		for(int u = u0; u < u0 + cols; u++) {
+			if( u < glyph->width && v >= 0 && v < glyph->height && get_bit2( glyph, u, v ) )
+				*buffer++ = fg;
+			else
+				*buffer++ = bg;
+		}
+	}
+}
+
+// the glyph rendered in the current colors, from the cache if it is there,
+// NULL if it is too large for it
+static const pixel_t *cached_glyph(eglib_t *eglib, const struct glyph_t *glyph, int head, int width, int first_row, int height) {
+	pixel_t fg = eglib->drawing.pixel_index[0];
+	pixel_t bg = eglib->drawing.pixel_index[1];
+	int lru = 0;
+
+	if( width * (height - first_row) > EGLIB_GLYPH_PIXELS )
+		return NULL;
+	glyph_clock++;
+	for(int i = 0; i < EGLIB_GLYPH_CACHE; i++) {
+		if( glyph_cache[i].used && glyph_cache[i].glyph == glyph && glyph_cache[i].font == eglib->drawing.font &&
+			glyph_cache[i].first_row == first_row && same_pixel( glyph_cache[i].fg, fg ) && same_pixel( glyph_cache[i].bg, bg ) ) {
+			glyph_cache[i].used = glyph_clock;
+			eglib_glyph_hits++;
+			return glyph_cache[i].pixels;
+		}
+		if( glyph_cache[i].used < glyph_cache[lru].used )
+			lru = i;
+	}
+	glyph_cache[lru].font = eglib->drawing.font;
+	glyph_cache[lru].glyph = glyph;
+	glyph_cache[lru].fg = fg;
+	glyph_cache[lru].bg = bg;
+	glyph_cache[lru].first_row = first_row;
+	glyph_cache[lru].used = glyph_clock;
+	render_glyph( eglib, glyph, head, 0, width, first_row, height - first_row, glyph_cache[lru].pixels );
+	eglib_glyph_misses++;
+	return glyph_cache[lru].pixels;
+}
 
 void eglib_DrawGlyph(eglib_t *eglib, coordinate_t x, coordinate_t y, const struct glyph_t *glyph) {
 	if(glyph == NULL)
 		return;
-	uint8_t *buffer;
 	int ascent = eglib->drawing.font->ascent;
 	int descent = eglib->drawing.font->descent;
 	int ascheight = ascent - descent;
@@ -1217,58 +1296,44 @@ void eglib_DrawGlyph(eglib_t *eglib, coordinate_t x, coordinate_t y, const struc
 
 	int top = glyph->top;
 	int head = ascent - top;
-	uint32_t pos3 = 0;
+	int top_y = y + alignment - height - 1;   // of row 0, where send_buffer() places it
 
-	int startx = MAX;
-	int starty = MAX;
-	int lenx = 0;
-	int leny = 0;
-
-	buffer = malloc( height*width*3 );
-	int y1 = 0;
+	int first_row = 0;
 	if( eglib->drawing.filled_mode == false ){
-		y1 =  height/8;   // WA as fonts bounding boxes to high over the top
+		first_row =  height/8;   // WA as fonts bounding boxes to high over the top
 	}
 
-	for(coordinate_t v1=y1; v1 < height ; v1++){
-		//char line[width+1];
-		for(coordinate_t u=0 ; u < width; u++) {
-			coordinate_t v = v1 - head;  // read glyph from right row
-			if( eglib_inClipArea( eglib, u+x+1, v1-height+y ) ){
-				if( startx > u )  // the following code captures the minimum bounding box from what is rendered
-					startx = u;
-				if( starty > v1 )
-					starty = v1;
-				if( lenx < u-startx )
-					lenx = u-startx;
-				if( leny < v1-starty )
-					leny = v1-starty;
-				*(color_t *)(buffer+pos3) = eglib->drawing.color_index[1];  // preinitialize with background
-				// line[u] = '.';
-				if( (u < glyph->width) && (v < glyph->height) && v>=0 && u>=0  )
-				{
-					if( get_bit2( glyph, u, v ) ){
-						*(color_t *)(buffer+pos3) = eglib->drawing.color_index[0];
-						// line[u] = 'X';
-					}
-				}
-				pos3 +=3;
-			}
-		}
-		// line[width] = 0;
-		// ESP_LOGI("Bitmap","L-%02d: %s", v1, line);   // debug bitmap
-	}
-	lenx += 1;
-	leny += 1;
+	// the part of rows first_row .. height-1 inside the clip area
+	int u0 = eglib->drawing.clip_xmin - x > 0 ? eglib->drawing.clip_xmin - x : 0;
+	int u1 = eglib->drawing.clip_xmax - x < width-1 ? eglib->drawing.clip_xmax - x : width-1;
+	int v0 = eglib->drawing.clip_ymin - top_y > first_row ? eglib->drawing.clip_ymin - top_y : first_row;
+	int v1 = eglib->drawing.clip_ymax - top_y < height-1 ? eglib->drawing.clip_ymax - top_y : height-1;
+	if( u0 > u1 || v0 > v1 )  // glyph is off clip area
+		return;
+	int cols = u1 - u0 + 1;
 
-	if( startx >= MAX || starty >= MAX ){ // glyph is off clip area
-		free( buffer );
+	const pixel_t *bitmap = cached_glyph( eglib, glyph, head, width, first_row, height );
+	if( bitmap == NULL )
+		eglib_glyph_misses++;
+	if( bitmap && cols == width && v0 == first_row && v1 == height-1 ){
+		eglib->display.driver->send_buffer( eglib, (void *)bitmap, x, top_y + v1 + 2, width, height - first_row );
 		return;
 	}
-	// ESP_LOGI("eglib_DrawGlyph 2","Window starts x:%d y:%d len x:%d y:%d", startx, starty, lenx, leny );
-	// ESP_LOGI("eglib_DrawGlyph 3","x:%d, y:%d, sx:%d sy:%d, wid:%d hei:%d", x,y, x+startx, y+alignment+starty -(height-leny), lenx, leny );
-	eglib->display.driver->send_buffer( eglib, buffer, x+startx, y+alignment+starty -(height-leny), lenx, leny );
-	free( buffer );
+	// clipped or too large for the cache, in as many rows as fit the scratch buffer
+	for(int v = v0; v <= v1; ){
+		int rows = EGLIB_GLYPH_PIXELS / cols;
+		if( rows > v1 - v + 1 )
+			rows = v1 - v + 1;
+		if( bitmap ){
+			for(int i = 0; i < rows; i++)
+				memcpy( glyph_scratch + i*cols, bitmap + (v + i - first_row)*width + u0, cols*sizeof(pixel_t) );
+		}
+		else
+			render_glyph( eglib, glyph, head, u0, cols, v, rows, glyph_scratch );
+		// ESP_LOGI("eglib_DrawGlyph 2","x:%d, y:%d, sx:%d sy:%d, wid:%d hei:%d", x,y, x+u0, top_y + v + rows + 1, cols, rows );
+		eglib->display.driver->send_buffer( eglib, glyph_scratch, x+u0, top_y + v + rows + 1, cols, rows );
+		v += rows;
+	}
 }
 
 
@@ -16,8 +16,17 @@
 
 typedef enum _font_origin {  FONT_BOTTOM, FONT_MIDDLE, FONT_TOP } e_font_origin;
 
+/* eglib_DrawGlyph() cache of coloured glyphs, 36 KB in 18 bit color, 24 KB in RGB565 */
+#ifndef EGLIB_GLYPH_CACHE
+#define EGLIB_GLYPH_CACHE   24    // glyphs kept, the least recently drawn replaced
+#endif
+#ifndef EGLIB_GLYPH_PIXELS
+#define EGLIB_GLYPH_PIXELS  512   // of each, larger ones are not kept
+#endif
+
 typedef struct s_drawing{
 		color_t color_index[4];
+		pixel_t pixel_index[4];   // color_index as sent, kept by eglib_SetIndexColor()
 		struct _gradient_t gradient;
 		const struct font_t *font;
 		bool filled_mode;
@@ -49,6 +58,18 @@ void eglib_SetIndexColor(
 	color_channel_t b
 );
 
+/** Color as sent to the display in the :c:macro:`EGLIB_RGB565` format. */
+static inline pixel_t eglib_ColorToPixel(color_t color) {
+#if EGLIB_RGB565
+	pixel_t pixel;
+	pixel.hi = (color.r & 0xf8) | color.g >> 5;
+	pixel.lo = (color.g & 0x1c) << 3 | color.b >> 3;
+	return pixel;
+#else
+	return color;
+#endif
+}
+
 /**
  * These are generic drawing functions.
  *
@@ -945,9 +966,17 @@ const struct glyph_t *eglib_GetGlyph(eglib_t *eglib, wchar_t unicode_char);
  *
  * .. image:: eglib_DrawGlyph.png
  *   :width: 200
+ *
+ * The glyph is kept in the colors of index 0 and 1 in a cache of
+ * :c:macro:`EGLIB_GLYPH_CACHE` glyphs, it is sent from there as long as
+ * font, glyph and colors are the same. Nothing is allocated.
  */
 void eglib_DrawGlyph(eglib_t *eglib, coordinate_t x, coordinate_t y, const struct glyph_t *glyph);
 
+/** Glyphs drawn from the cache and rendered anew, since boot. */
+extern uint32_t eglib_glyph_hits;
+extern uint32_t eglib_glyph_misses;
+
 /**
  * Draw given unicode character glyph at ``(x, y)``.
  *
@@ -9,6 +9,8 @@ extern "C" {
 #include "esp32_ili9341.h"
 
 static esp32_hal_config_t *config;
+uint32_t esp32_ili9341_bytes = 0;
+uint32_t esp32_ili9341_transfers = 0;
 
 static void einit(eglib_t *eglib) {
 	ESP_LOGI("ILI9341","init()");
@@ -75,6 +77,8 @@ void esend(
     	gpio_set_level(config->gpio_dc, 0 );
     }
 	SPI.transfer( bytes, length );
+	esp32_ili9341_bytes += length;
+	esp32_ili9341_transfers++;
 }
 
 static void ecomm_end(eglib_t *_eglib) {
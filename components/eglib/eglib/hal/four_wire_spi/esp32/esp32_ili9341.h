@@ -31,4 +31,9 @@ typedef struct esp32_hal_config{
 	gpio_num_t gpio_rs;
 }esp32_hal_config_t;
 
+// bytes handed to SPI.transfer() since boot, commands and addresses included,
+// and the number of calls
+extern uint32_t esp32_ili9341_bytes;
+extern uint32_t esp32_ili9341_transfers;
+
 // void send( eglib_t *_eglib, enum hal_dc_t dc, uint8_t *bytes, uint32_t length );
@@ -0,0 +1,194 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "driver/spi_master.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#include "driver/gpio.h"
+#include <esp_log.h>
+#include <string.h>
+
+extern "C" {
+#include "esp32_ili9341_dma.h"
+
+static esp32_hal_config_t *config;
+static spi_device_handle_t spi;
+static gpio_num_t dc_pin;
+static spi_transaction_t trans[ESP32_ILI9341_DMA_QUEUE];
+static uint32_t queued = 0;         // transactions since boot, the n-th one in trans[(n-1) % ESP32_ILI9341_DMA_QUEUE]
+static uint32_t done = 0;           // of them returned by spi_device_get_trans_result()
+static uint8_t *line[2];
+static uint32_t line_last[2] = { 0, 0 };   // last transaction sending from each line buffer
+static int cur = 0;
+static uint32_t fill = 0;           // bytes of line[cur] in use
+
+// DC of the transaction about to start, called from the SPI interrupt
+static void IRAM_ATTR pre_transfer( spi_transaction_t *t ) {
+	gpio_set_level( dc_pin, (uint32_t)(intptr_t)t->user );
+}
+
+// until the n-th transaction went out, in order of queueing
+static void wait( uint32_t n ) {
+	spi_transaction_t *t;
+	while( (int32_t)(n - done) > 0 ){
+		spi_device_get_trans_result( spi, &t, portMAX_DELAY );
+		done++;
+	}
+}
+
+static void flush() {
+	wait( queued );
+}
+
+// returns the number of the transaction
+static uint32_t queue( enum hal_dc_t dc, const uint8_t *bytes, uint32_t length ) {
+	wait( queued + 1 - ESP32_ILI9341_DMA_QUEUE );   // its slot is free
+	spi_transaction_t *t = &trans[queued % ESP32_ILI9341_DMA_QUEUE];
+	memset( t, 0, sizeof(*t) );
+	t->length = length * 8;
+	t->user = (void *)(intptr_t)(dc == HAL_DATA);
+	if( length <= 4 ){
+		t->flags = SPI_TRANS_USE_TXDATA;
+		memcpy( t->tx_data, bytes, length );
+	}
+	else
+		t->tx_buffer = bytes;
+	spi_device_queue_trans( spi, t, portMAX_DELAY );
+	esp32_ili9341_transfers++;
+	return ++queued;
+}
+
+// spi_num is numbered as the buses of Arduino SPI, see esp32-hal-spi.c
+static int spiHost( uint8_t spi_num ) {
+#if CONFIG_IDF_TARGET_ESP32
+	return spi_num - 1;   // HSPI 2 is SPI2_HOST, VSPI 3 SPI3_HOST
+#elif CONFIG_IDF_TARGET_ESP32S2
+	return spi_num;       // FSPI 1 is SPI2_HOST, HSPI 2 SPI3_HOST
+#else
+	return spi_num + 1;   // FSPI 0 is SPI2_HOST, HSPI 1 SPI3_HOST
+#endif
+}
+
+static void einit(eglib_t *eglib) {
+	ESP_LOGI("ILI9341","init() DMA");
+	config = (esp32_hal_config_t *)eglib_GetHalConfig(eglib);
+	int host = spiHost( config->spi_num );
+	if( host < SPI2_HOST || host >= SOC_SPI_PERI_NUM ){   // SPI1 is the flash
+		ESP_LOGE("ILI9341","spi_num %d is no general purpose SPI host", config->spi_num );
+		ESP_ERROR_CHECK( ESP_ERR_INVALID_ARG );
+	}
+	dc_pin = config->gpio_dc;
+	gpio_reset_pin(config->gpio_rs);
+	gpio_reset_pin(config->gpio_dc);
+	gpio_set_direction(config->gpio_rs, GPIO_MODE_OUTPUT);
+	gpio_set_direction(config->gpio_dc, GPIO_MODE_OUTPUT);
+	gpio_set_level(config->gpio_rs, 1);
+	gpio_set_level(config->gpio_dc, 1 );
+
+	spi_bus_config_t bus = {};
+	bus.mosi_io_num = config->gpio_sda;
+	bus.miso_io_num = -1;               // write only
+	bus.sclk_io_num = config->gpio_scl;
+	bus.quadwp_io_num = -1;
+	bus.quadhd_io_num = -1;
+	bus.max_transfer_sz = ESP32_ILI9341_DMA_LINE;
+	ESP_ERROR_CHECK( spi_bus_initialize( (spi_host_device_t)host, &bus, SPI_DMA_CH_AUTO ) );
+
+	spi_device_interface_config_t dev = {};
+	dev.mode = config->dataMode;
+	dev.clock_speed_hz = config->freq;
+	dev.spics_io_num = config->gpio_cs;
+	dev.queue_size = ESP32_ILI9341_DMA_QUEUE;
+	dev.pre_cb = pre_transfer;
+	ESP_ERROR_CHECK( spi_bus_add_device( (spi_host_device_t)host, &dev, &spi ) );
+
+	for( int i=0; i<2; i++ ){
+		line[i] = (uint8_t *)heap_caps_malloc( ESP32_ILI9341_DMA_LINE, MALLOC_CAP_DMA );
+		if( line[i] == NULL ){   // no display without both, stop here rather than DMA from NULL later
+			ESP_LOGE("ILI9341","no DMA memory for line buffer %d (%d bytes), largest free block %d", i,
+					ESP32_ILI9341_DMA_LINE, (int)heap_caps_get_largest_free_block( MALLOC_CAP_DMA ) );
+			ESP_ERROR_CHECK( ESP_ERR_NO_MEM );
+		}
+	}
+	ESP_LOGI("ILI9341","SPI%d %d kHz, line buffers %p %p", host+1, spi_get_actual_clock( APB_CLK_FREQ, config->freq, 128 )/1000, line[0], line[1] );
+}
+
+static void esleep_in(eglib_t *_eglib) {
+	ESP_LOGI("ILI9341","sleep in");
+	flush();
+	vTaskDelay( 120 / portTICK_PERIOD_MS);
+}
+
+static void esleep_out(eglib_t *_eglib) {
+	ESP_LOGI("ILI9341","sleep out");
+	flush();
+	vTaskDelay( 120 / portTICK_PERIOD_MS);
+}
+
+static void edelay_ns(eglib_t *_eglib, uint32_t ns) {
+	ESP_LOGI("ILI9341","delay %d ms", ns/1000000 );
+	flush();
+	vTaskDelay( (ns/1000000) / portTICK_PERIOD_MS);
+}
+
+static void eset_reset(eglib_t *_eglib, bool state) {
+	ESP_LOGI("ILI9341","reset IO:%d state=%d", config->gpio_rs, state );
+	flush();
+	gpio_set_level(config->gpio_rs, (unsigned int)state );
+}
+
+static bool eget_busy(eglib_t *_eglib) {
+    return false;
+}
+
+// CS is up to spi_master, and nothing waits for the transactions to go out
+static void ecomm_begin(eglib_t *_eglib) {
+}
+
+// Copies into the line buffer in use while it has room, else into the other
+// one, once its last transaction went out. Longer sends go in chunks of a
+// line buffer.
+static void esend(
+	eglib_t *_eglib,
+	enum hal_dc_t dc,
+	uint8_t *bytes,
+	uint32_t length )
+{
+	esp32_ili9341_bytes += length;
+	if( length <= 4 ){
+		if( length )
+			queue( dc, bytes, length );
+		return;
+	}
+	while( length ){
+		uint32_t n = length < ESP32_ILI9341_DMA_LINE ? length : ESP32_ILI9341_DMA_LINE;
+		if( fill + n > ESP32_ILI9341_DMA_LINE ){
+			cur = !cur;
+			wait( line_last[cur] );
+			fill = 0;
+		}
+		uint8_t *p = line[cur] + fill;
+		memcpy( p, bytes, n );
+		line_last[cur] = queue( dc, p, n );
+		fill += (n + 3) & ~3;   // DMA from word aligned addresses
+		bytes += n;
+		length -= n;
+	}
+}
+
+static void ecomm_end(eglib_t *_eglib) {
+}
+
+hal_t esp32_ili9341_dma = {
+	.init = einit,
+	.sleep_in = esleep_in,
+	.sleep_out = esleep_out,
+	.delay_ns = edelay_ns,
+	.set_reset = eset_reset,
+	.get_busy = eget_busy,
+	.comm_begin = ecomm_begin,
+	.send = esend,
+	.comm_end = ecomm_end,
+};
+}
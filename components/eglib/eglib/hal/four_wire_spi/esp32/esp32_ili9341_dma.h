@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * Driver
+ * ======
+ */
+
+/**
+ * 4-Wire SPI HAL driver for ESP32 ILI9341 four wire SPI IPS display module,
+ * on the ESP-IDF spi_master driver instead of Arduino SPI.
+ *
+ * Every send is queued as a DMA transaction and returns before it is on the
+ * wire, the DC level is set by the driver right before each transaction
+ * starts. Data is copied into one of two line buffers, so the caller may
+ * reuse its buffer at once and render the next span while the last one is
+ * sent. Sends of up to 4 bytes, commands and most parameters, go in the
+ * transaction itself. CS is driven by spi_master for each transaction.
+ *
+ * Takes the same esp32_hal_config_t as esp32_ili9341, spi_num numbered as the
+ * Arduino SPI buses (FSPI, HSPI), SPI1 of the flash is refused. Counts into
+ * esp32_ili9341_bytes and esp32_ili9341_transfers, one transfer per
+ * transaction.
+ *
+ * :See also: :c:func:`eglib_Init`.
+ */
+
+
+#include "hal.h"
+#include "esp32_ili9341.h"
+
+#define ESP32_ILI9341_DMA_LINE   (320*3*8)   // bytes of each line buffer, 8 lines of 320 pixels
+#define ESP32_ILI9341_DMA_QUEUE  16          // transactions in flight, a power of 2
+
+extern hal_t esp32_ili9341_dma;
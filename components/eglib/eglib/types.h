@@ -105,6 +105,29 @@ typedef struct {
 	color_channel_t b;
 } color_t;
 
+/**
+ * Build time pixel format of the buffers sent as a whole (glyphs, tiles) and
+ * of the display: ``1`` for RGB565 in 2 bytes, ``0`` for 18bit color in 3
+ * bytes. The ILI9341 has to be configured to match.
+ */
+#ifndef EGLIB_RGB565
+#define EGLIB_RGB565 0
+#endif
+
+/**
+ * A pixel as sent to the display, see :c:func:`eglib_ColorToPixel`.
+ */
+#if EGLIB_RGB565
+typedef struct {
+	/** ``RRRRRGGG`` */
+	uint8_t hi;
+	/** ``GGGBBBBB`` */
+	uint8_t lo;
+} pixel_t;
+#else
+typedef color_t pixel_t;
+#endif
+
 
 
 struct _eglib_struct;
@@ -2,6 +2,7 @@
 #include "eglib.h"
 #include <eglib/display/ili9341.h>
 #include <eglib/hal/four_wire_spi/esp32/esp32_ili9341.h>
+#include <eglib/hal/four_wire_spi/esp32/esp32_ili9341_dma.h>
 #include "logdef.h"
 #include "SetupNG.h"
 #include "Colors.h"
@@ -50,7 +51,7 @@ uint8_t PROGMEM eglib_font_free_sansbold_66[] = { EGLIB_FONT_FREE_SANSBOLD_66 };
 static ili9341_config_t ili9341_config = {
     .width = DISPLAY_W,
     .height = DISPLAY_W,
-    .color = ILI9341_COLOR_18_BIT,
+    .color = EGLIB_RGB565 ? ILI9341_COLOR_16_BIT : ILI9341_COLOR_18_BIT,
 #if DISPLAY_W == 240  // 2.4-inch display
     .page_address = ILI9341_PAGE_ADDRESS_TOP_TO_BOTTOM,
     .colum_address = ILI9341_COLUMN_ADDRESS_LEFT_TO_RIGHT,
@@ -67,7 +68,7 @@ static ili9341_config_t ili9341_config = {
 };
 
 static PROGMEM esp32_hal_config_t esp32_ili9341_config = {
-		.spi_num = 	HSPI,
+		.spi_num = 	FSPI,   // the bus of Arduino SPI
 		.freq = 	13111111*3,
 		.dataMode = SPI_MODE0,
 		.bitOrder = MSBFIRST,
@@ -79,79 +80,73 @@ static PROGMEM esp32_hal_config_t esp32_ili9341_config = {
 		.gpio_rs  = RESET_Display,
 };
 
-void AdaptUGC::setFont(uint8_t *f, bool filled ){    // adapter
-	eglib_setFilledMode( eglib, filled );
+const struct font_t *AdaptUGC::getFont( uint8_t *f ){    // adapter
 	switch( f[0] ){
 	case UCG_FONT_9x15B_MF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeMonoBold_15px);
-		break;
+		return &font_FreeFont_FreeMonoBold_15px;
 	case UCG_FONT_NCENR14_HR:
-		eglib_SetFont(eglib, &font_Adobe_NewCenturySchoolbookRoman_20px);
-		break;
+		return &font_Adobe_NewCenturySchoolbookRoman_20px;
 	case UCG_FONT_FUB11_TR:
-		eglib_SetFont(eglib, &font_Adobe_HelveticaBold_17px);
-		break;
+		return &font_Adobe_HelveticaBold_17px;
 	case UCG_FONT_FUB11_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_18px);
-		break;
+		return &font_FreeFont_FreeSansBold_18px;
 	case UCG_FONT_FUB11_HR:
-		eglib_SetFont(eglib, &font_Adobe_HelveticaBold_17px);
-		break;
+		return &font_Adobe_HelveticaBold_17px;
 	case UCG_FONT_FUB14_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_18px);
-		break;
+		return &font_FreeFont_FreeSansBold_18px;
 	case UCG_FONT_FUB14_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_20px);
-		break;
+		return &font_FreeFont_FreeSansBold_20px;
 	case UCG_FONT_FUB14_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_20px);
-		break;
+		return &font_FreeFont_FreeSansBold_20px;
 	case UCG_FONT_FUR14_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSans_20px);
-		break;
+		return &font_FreeFont_FreeSans_20px;
 	case UCG_FONT_FUB17_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_24px);
-		break;
+		return &font_FreeFont_FreeSansBold_24px;
 	case UCG_FONT_FUB20_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_28px);
-		break;
+		return &font_FreeFont_FreeSansBold_28px;
 	case UCG_FONT_FUB20_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_28px);
-		break;
+		return &font_FreeFont_FreeSansBold_28px;
 	case UCG_FONT_FUB20_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_28px);
-		break;
+		return &font_FreeFont_FreeSansBold_28px;
 	case UCG_FONT_FUB25_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
-		break;
+		return &font_FreeFont_FreeSansBold_32px;
 	case UCG_FONT_FUB25_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
-		break;
+		return &font_FreeFont_FreeSansBold_32px;
 	case UCG_FONT_FUR25_HF:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
-		break;
+		return &font_FreeFont_FreeSansBold_32px;
 	case UCG_FONT_FUB25_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_32px);
-		break;
+		return &font_FreeFont_FreeSansBold_32px;
 	case UCG_FONT_FUB35_HN:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_48px);
-		break;
+		return &font_FreeFont_FreeSansBold_48px;
 	case UCG_FONT_FUB35_HR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_48px);
-		break;
+		return &font_FreeFont_FreeSansBold_48px;
 	case EGLIB_FONT_FREE_SANSBOLD_66:
-                eglib_SetFont(eglib, &font_FreeFont_FreeSansBold_66px);
-                break;
+		return &font_FreeFont_FreeSansBold_66px;
 	case UCG_FONT_PROFONT22_MR:
-		eglib_SetFont(eglib, &font_FreeFont_FreeMonoBold_20px);
-		break;
+		return &font_FreeFont_FreeMonoBold_20px;
 	default:
-		printf("No Font found !\n");
+		return nullptr;
 	}
 };
 
+void AdaptUGC::setFont(uint8_t *f, bool filled ){
+	eglib_setFilledMode( eglib, filled );
+	const struct font_t *font = getFont( f );
+	if( font )
+		eglib_SetFont(eglib, font);
+	else
+		printf("No Font found !\n");
+};
+
 #define EGL_DISPLAY_TOPDOWN 1
 #define EGL_WHITE_ON_BLACK 1
+#define EGL_SPI_DMA 0          // 1 for queued DMA transactions of spi_master, not yet checked on the device
+
+#if EGL_SPI_DMA
+#define EGL_HAL esp32_ili9341_dma
+#else
+#define EGL_HAL esp32_ili9341
+#endif
 
 void  AdaptUGC::begin() {
 	eglib = &myeglib;
@@ -164,8 +159,8 @@ void  AdaptUGC::begin() {
 	}
 	setRedBlueTwist(true);
 #endif
-	ESP_LOGI(FNAME, "eglib_Send() &eglib:%x  hal-driv:%x config:%x\n", (unsigned int)eglib, (unsigned int)&esp32_ili9341, (unsigned int)&esp32_ili9341_config );
-	eglib_Init( &myeglib, &esp32_ili9341, &esp32_ili9341_config, &ili9341, &ili9341_config );
+	ESP_LOGI(FNAME, "eglib_Send() &eglib:%x  hal-driv:%x config:%x\n", (unsigned int)eglib, (unsigned int)&EGL_HAL, (unsigned int)&esp32_ili9341_config );
+	eglib_Init( &myeglib, &EGL_HAL, &esp32_ili9341_config, &ili9341, &ili9341_config );
 	setClipRange( 0,0, DISPLAY_W, DISPLAY_H );
 };
 
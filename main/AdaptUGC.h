@@ -100,16 +100,22 @@ public:
 	void invertDisplay( bool inv ) {invertDisp=inv;};  	        // solved in grafic layer
 	void setRedBlueTwist( bool twist ) {twistRB= twist;};   	    // no more needed, type of displays phased out
 	inline void undoClipRange() { eglib_undoClipRange(eglib);};
+	inline eglib_t *getEglib() { return eglib; };
 	// color
+	inline color_t toColor( uint8_t r, uint8_t g, uint8_t b ) {   // as sent to the display
+		color_t c;
+		c.r = invertDisp ? ~(twistRB ? b : r) : (twistRB ? b : r);
+		c.g = invertDisp ? ~g : g;
+		c.b = invertDisp ? ~(twistRB ? r : b) : (twistRB ? r : b);
+		return c;
+	}
+	inline color_t toColor( ucg_color_t c ) { return toColor( c.color[0],c.color[1],c.color[2] ); };
 	inline void setColor( uint8_t idx, uint8_t r, uint8_t g, uint8_t b ) {
-		twistRB?
-				eglib_SetIndexColor(eglib, idx, invertDisp?~b:b, invertDisp?~g:g, invertDisp?~r:r):
-				eglib_SetIndexColor(eglib, idx, invertDisp?~r:r, invertDisp?~g:g, invertDisp?~b:b);
+		color_t c = toColor( r, g, b );
+		eglib_SetIndexColor(eglib, idx, c.r, c.g, c.b);
 	}
 	inline void setColor( uint8_t r, uint8_t g, uint8_t b ) {
-		twistRB?
-				eglib_SetIndexColor(eglib, 0, invertDisp?~b:b, invertDisp?~g:g, invertDisp?~r:r):
-				eglib_SetIndexColor(eglib, 0, invertDisp?~r:r, invertDisp?~g:g, invertDisp?~b:b);
+		setColor( 0, r, g, b );
 	}
 	inline void setColor( ucg_color_t c ) {
 		setColor( c.color[0],c.color[1],c.color[2] );
@@ -137,6 +143,8 @@ public:
 	inline int16_t getStrWidth( const char * s ) { return ( eglib_GetTextWidth(eglib, s) ); };
 	// Font related
 	void setFont(uint8_t *f, bool filled=false );
+	static const struct font_t *getFont( uint8_t *f );   // eglib font of the ucg font, nullptr if unknown
+	inline e_font_origin getFontOrigin() { return eglib->drawing.font_origin; };
 	void setFontMode( uint8_t is_transparent ) {};  // no concept for transparent fonts in eglib, as it appears
 	inline void setFontPosBottom() {  eglib_setFontOrigin( eglib, FONT_BOTTOM ); };
 	inline void setFontPosCenter() {   eglib_setFontOrigin( eglib, FONT_MIDDLE ); };
@@ -0,0 +1,261 @@
+/*
+ * Compositor.cpp
+ *
+ */
+
+#include "Compositor.h"
+#include <cstring>
+#include <algorithm>
+
+eglib_t Compositor::tile;
+tile_config_t Compositor::tile_config;
+pixel_t Compositor::buffer[COMP_TILE_PIXELS];
+color_t Compositor::background = { 0, 0, 0 };
+int Compositor::width = 0;
+int Compositor::height = 0;
+comp_scene_t Compositor::scene[2];
+int Compositor::cur = 0;
+bool Compositor::invalid = true;
+bool Compositor::renew = false;
+comp_rect_t Compositor::dmg[COMP_DAMAGE];
+int Compositor::num_dmg = 0;
+uint32_t Compositor::rects = 0;
+uint32_t Compositor::pixels = 0;
+uint32_t Compositor::dropped = 0;
+
+// FNV-1a
+static uint32_t hashBytes( uint32_t h, const void *p, size_t len ){
+	const uint8_t *b = (const uint8_t *)p;
+	while( len-- ){
+		h ^= *b++;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static inline comp_rect_t unite( const comp_rect_t &a, const comp_rect_t &b ){
+	return { std::min( a.x0, b.x0 ), std::min( a.y0, b.y0 ), std::max( a.x1, b.x1 ), std::max( a.y1, b.y1 ) };
+}
+
+static inline bool overlaps( const comp_rect_t &a, const comp_rect_t &b, int gap=0 ){
+	return a.x0 <= b.x1 + gap && b.x0 <= a.x1 + gap && a.y0 <= b.y1 + gap && b.y0 <= a.y1 + gap;
+}
+
+static inline int area( const comp_rect_t &r ){
+	return (r.x1 - r.x0 + 1) * (r.y1 - r.y0 + 1);
+}
+
+static bool same( const comp_item_t &a, const comp_scene_t &sa, const comp_item_t &b, const comp_scene_t &sb ){
+	if( memcmp( &a.prim, &b.prim, sizeof(a.prim) ) )
+		return false;
+	return a.text < 0 || strcmp( sa.text[a.text], sb.text[b.text] ) == 0;
+}
+
+void Compositor::begin( eglib_t *display, int w, int h, color_t bg ){
+	width = w;
+	height = h;
+	background = bg;
+	eglib_Init_Tile( &tile, &tile_config, display, buffer, COMP_TILE_PIXELS );
+	eglib_SetIndexColor( &tile, 1, bg.r, bg.g, bg.b );   // behind glyphs
+	invalid = true;
+}
+
+void Compositor::beginFrame(){
+	cur = !cur;
+	scene[cur].num = 0;
+	scene[cur].num_texts = 0;
+}
+
+comp_item_t *Compositor::add( int type, color_t color ){
+	comp_scene_t &s = scene[cur];
+	if( s.num >= COMP_PRIMS ){
+		dropped++;
+		return nullptr;
+	}
+	comp_item_t &it = s.item[s.num++];
+	memset( &it.prim, 0, sizeof(it.prim) );
+	it.prim.type = type;
+	it.prim.color = color;
+	it.text = -1;
+	return &it;
+}
+
+// hash and box of the geometric primitives right away, texts are measured
+// in endFrame() only if they are new
+void Compositor::triangle( int x0, int y0, int x1, int y1, int x2, int y2, color_t color ){
+	comp_item_t *it = add( COMP_TRIANGLE, color );
+	if( !it )
+		return;
+	int16_t *p = it->prim.p;
+	p[0] = x0; p[1] = y0; p[2] = x1; p[3] = y1; p[4] = x2; p[5] = y2;
+	it->box = { (int16_t)std::min( { x0, x1, x2 } ), (int16_t)std::min( { y0, y1, y2 } ), (int16_t)std::max( { x0, x1, x2 } ), (int16_t)std::max( { y0, y1, y2 } ) };
+	it->hash = hashBytes( 2166136261u, &it->prim, sizeof(it->prim) );
+}
+
+void Compositor::tetragon( int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3, color_t color ){
+	comp_item_t *it = add( COMP_TETRAGON, color );
+	if( !it )
+		return;
+	int16_t *p = it->prim.p;
+	p[0] = x0; p[1] = y0; p[2] = x1; p[3] = y1; p[4] = x2; p[5] = y2; p[6] = x3; p[7] = y3;
+	it->box = { (int16_t)std::min( { x0, x1, x2, x3 } ), (int16_t)std::min( { y0, y1, y2, y3 } ), (int16_t)std::max( { x0, x1, x2, x3 } ), (int16_t)std::max( { y0, y1, y2, y3 } ) };
+	it->hash = hashBytes( 2166136261u, &it->prim, sizeof(it->prim) );
+}
+
+void Compositor::circle( int x, int y, int radius, color_t color ){
+	comp_item_t *it = add( COMP_CIRCLE, color );
+	if( !it )
+		return;
+	it->prim.p[0] = x; it->prim.p[1] = y; it->prim.p[2] = radius;
+	it->box = { (int16_t)(x-radius), (int16_t)(y-radius), (int16_t)(x+radius), (int16_t)(y+radius) };
+	it->hash = hashBytes( 2166136261u, &it->prim, sizeof(it->prim) );
+}
+
+void Compositor::text( int x, int y, const struct font_t *font, e_font_origin origin, color_t color, const char *str ){
+	comp_scene_t &s = scene[cur];
+	if( !font || !str[0] )
+		return;
+	if( s.num_texts >= COMP_TEXTS ){
+		dropped++;
+		return;
+	}
+	comp_item_t *it = add( COMP_TEXT, color );
+	if( !it )
+		return;
+	it->prim.origin = origin;
+	it->prim.font = font;
+	it->prim.p[0] = x; it->prim.p[1] = y;
+	it->text = s.num_texts++;
+	strncpy( s.text[it->text], str, COMP_TEXT_LEN-1 );
+	s.text[it->text][COMP_TEXT_LEN-1] = '\0';
+	it->hash = hashBytes( hashBytes( 2166136261u, &it->prim, sizeof(it->prim) ), s.text[it->text], strlen( s.text[it->text] ) );
+	it->box = { 1, 0, 0, 0 };   // see measure()
+}
+
+// box of a text, drawn once on the tile without writing anything
+void Compositor::measure( comp_item_t &it, const comp_scene_t &s ){
+	if( it.prim.type != COMP_TEXT )
+		return;
+	eglib_undoClipRange( &tile );
+	tile_BeginMeasure( &tile );
+	render( it, s );
+	if( !tile_EndMeasure( &tile, &it.box.x0, &it.box.y0, &it.box.x1, &it.box.y1 ) )
+		it.box = { 1, 0, 0, 0 };
+}
+
+void Compositor::render( const comp_item_t &it, const comp_scene_t &s ){
+	const comp_prim_t &p = it.prim;
+	eglib_SetIndexColor( &tile, 0, p.color.r, p.color.g, p.color.b );
+	switch( p.type ){
+	case COMP_TRIANGLE:
+		eglib_DrawFilledTriangle( &tile, p.p[0], p.p[1], p.p[2], p.p[3], p.p[4], p.p[5] );
+		break;
+	case COMP_TETRAGON:
+		eglib_DrawTetragon( &tile, p.p[0], p.p[1], p.p[2], p.p[3], p.p[4], p.p[5], p.p[6], p.p[7] );
+		break;
+	case COMP_CIRCLE:
+		eglib_DrawCircle( &tile, p.p[0], p.p[1], p.p[2], EGLIB_DRAW_ALL );
+		break;
+	case COMP_TEXT:
+		eglib_SetFont( &tile, p.font );
+		eglib_setFontOrigin( &tile, (e_font_origin)p.origin );
+		eglib_DrawText( &tile, p.p[0], p.p[1], s.text[it.text] );
+		break;
+	}
+}
+
+// the box grown by a pixel against rounding of the rasterizers, clipped to
+// the screen, merged with every damaged rectangle closer than COMP_MERGE_GAP
+void Compositor::damage( comp_rect_t r ){
+	if( r.x0 > r.x1 )
+		return;
+	r = { (int16_t)std::max( r.x0-1, 0 ), (int16_t)std::max( r.y0-1, 0 ), (int16_t)std::min( r.x1+1, width-1 ), (int16_t)std::min( r.y1+1, height-1 ) };
+	if( r.x0 > r.x1 || r.y0 > r.y1 )
+		return;
+	for(;;){
+		int k;
+		for( k=0; k<num_dmg && !overlaps( r, dmg[k], COMP_MERGE_GAP ); k++ )
+			;
+		if( k == num_dmg ){
+			if( num_dmg < COMP_DAMAGE )
+				break;
+			// full, merge with the one growing least
+			int grow = INT32_MAX;
+			for( int i=0; i<num_dmg; i++ ){
+				int g = area( unite( r, dmg[i] ) ) - area( dmg[i] );
+				if( g < grow ){
+					grow = g;
+					k = i;
+				}
+			}
+		}
+		r = unite( r, dmg[k] );
+		dmg[k] = dmg[--num_dmg];
+	}
+	dmg[num_dmg++] = r;
+}
+
+// r from the current scene, in bands of as many lines as fit the tile
+void Compositor::draw( const comp_rect_t &r ){
+	const comp_scene_t &s = scene[cur];
+	int w = r.x1 - r.x0 + 1;
+	int lines = std::max( 1, COMP_TILE_PIXELS / w );
+	for( int y = r.y0; y <= r.y1; y += lines ){
+		int h = std::min( lines, r.y1 - y + 1 );
+		comp_rect_t band = { r.x0, (int16_t)y, r.x1, (int16_t)(y+h-1) };
+		tile_SetWindow( &tile, r.x0, y, w, h );
+		tile_Fill( &tile, background );
+		eglib_setClipRange( &tile, r.x0, y, w, h );
+		for( int i=0; i<s.num; i++ ){
+			const comp_rect_t &b = s.item[i].box;
+			if( b.x0 <= b.x1 && overlaps( b, band ) )
+				render( s.item[i], s );
+		}
+		tile_Send( &tile );
+		pixels += w*h;
+	}
+}
+
+// Both scenes are walked in hash order: a primitive found in both keeps its
+// box and costs nothing, the others damage their box of the frame they are in.
+void Compositor::endFrame(){
+	static uint8_t order_old[COMP_PRIMS];
+	static uint8_t order_new[COMP_PRIMS];
+	comp_scene_t &n = scene[cur];
+	const comp_scene_t &o = scene[!cur];
+	int num_old = invalid ? 0 : o.num;
+	invalid = false;
+	num_dmg = 0;
+	for( int i=0; i<num_old; i++ )
+		order_old[i] = i;
+	for( int i=0; i<n.num; i++ )
+		order_new[i] = i;
+	std::sort( order_old, order_old+num_old, [&o]( uint8_t a, uint8_t b ){ return o.item[a].hash < o.item[b].hash; } );
+	std::sort( order_new, order_new+n.num, [&n]( uint8_t a, uint8_t b ){ return n.item[a].hash < n.item[b].hash; } );
+	int i = 0, j = 0;
+	while( i < num_old || j < n.num ){
+		const comp_item_t *a = i < num_old ? &o.item[order_old[i]] : nullptr;
+		comp_item_t *b = j < n.num ? &n.item[order_new[j]] : nullptr;
+		if( a && b && a->hash == b->hash && same( *a, o, *b, n ) ){
+			b->box = a->box;
+			i++; j++;
+		}
+		else if( a && (!b || a->hash <= b->hash) ){
+			damage( a->box );
+			i++;
+		}
+		else {
+			measure( *b, n );
+			damage( b->box );
+			j++;
+		}
+	}
+	if( renew ){
+		for( int k=0; k<n.num; k++ )
+			damage( n.item[k].box );
+		renew = false;
+	}
+	for( int k=0; k<num_dmg; k++ )
+		draw( dmg[k] );
+	rects += num_dmg;
+}
@@ -0,0 +1,116 @@
+/*
+ * Compositor.h
+ *
+ * Radar screen kept as a retained scene instead of erasing in black. Each
+ * frame, between beginFrame() and endFrame(), the own airplane, the targets
+ * and the info fields add their primitives. endFrame() compares the scene
+ * with the one of the last frame: the boxes of primitives that disappeared,
+ * appeared or changed are damaged, boxes overlapping or closer than
+ * COMP_MERGE_GAP are merged. Each damaged rectangle is rendered again from
+ * the whole current scene, band by band into a tile buffer (eglib tile
+ * display), and sent in one transfer per band. Overlapping symbols no longer
+ * punch holes into each other, and unchanged ones are not sent at all.
+ *
+ * Whatever is drawn directly to the display (status texts, menus) is not part
+ * of the scene and can be covered by a damaged rectangle. After the screen
+ * was cleared, invalidate() has the whole scene drawn again, refresh() does
+ * so over what is on the screen, repairing what was drawn over it.
+ *
+ * Free of ESP-IDF and Arduino includes, colors are passed as sent to the
+ * display (AdaptUGC::toColor()), so tools/spi_replay.cpp can run it on the
+ * host too.
+ */
+
+#ifndef MAIN_COMPOSITOR_H_
+#define MAIN_COMPOSITOR_H_
+
+#include <cstdint>
+extern "C" {
+#include "eglib.h"
+#include <eglib/display/tile.h>
+}
+#include "TargetTable.h"
+
+// Per frame, for a full target table: a triangle per target, the climb of the
+// best climber, a circle around the nearest and two around the team target,
+// airplane (3), north, range circle and the 8 info fields. Nothing is dropped
+// then, takeDropped() only counts what would overflow a changed layout.
+#define COMP_PRIMS        ((int)TargetTable< uint8_t, TARGET_TABLE_SLOTS >::MAX_ENTRIES + 4 + 13)
+#define COMP_TEXTS        16     // north, info fields, climb
+#define COMP_TEXT_LEN     32
+#define COMP_DAMAGE       16     // rectangles per frame, more are merged
+#define COMP_MERGE_GAP    8      // px, closer rectangles are merged
+#define COMP_TILE_PIXELS  4096   // 12 KB in 18 bit color, 8 KB in RGB565, 12 lines of the 320 px display
+
+#define COMP_TRIANGLE  0
+#define COMP_TETRAGON  1
+#define COMP_CIRCLE    2
+#define COMP_TEXT      3
+
+typedef struct {
+	int16_t x0, y0, x1, y1;   // inclusive, empty if x0 > x1
+} comp_rect_t;
+
+// compared byte by byte between frames, so created zeroed
+typedef struct {
+	uint8_t  type;     // COMP_TRIANGLE ...
+	uint8_t  origin;   // e_font_origin of a text
+	color_t  color;
+	const struct font_t *font;
+	int16_t  p[8];     // corners, center and radius, or print position
+} comp_prim_t;
+
+typedef struct {
+	comp_prim_t prim;
+	int8_t      text;   // index into comp_scene_t::text, -1 if none
+	uint32_t    hash;
+	comp_rect_t box;
+} comp_item_t;
+
+typedef struct {
+	int num;
+	int num_texts;
+	comp_item_t item[COMP_PRIMS];
+	char text[COMP_TEXTS][COMP_TEXT_LEN];
+} comp_scene_t;
+
+class Compositor {
+	static_assert( COMP_PRIMS <= 256, "endFrame() sorts the scene by uint8_t index" );
+public:
+	static void begin( eglib_t *display, int width, int height, color_t background );
+	static void beginFrame();
+	static void triangle( int x0, int y0, int x1, int y1, int x2, int y2, color_t color );
+	static void tetragon( int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3, color_t color );
+	static void circle( int x, int y, int radius, color_t color );
+	static void text( int x, int y, const struct font_t *font, e_font_origin origin, color_t color, const char *s );
+	static void endFrame();
+	static inline void invalidate() { invalid = true; };   // the screen was cleared
+	static inline void refresh() { renew = true; };        // send the whole scene with the next frame
+	// since the last call, logged by TargetManager
+	static inline uint32_t takeRects() { uint32_t r = rects; rects = 0; return r; };
+	static inline uint32_t takePixels() { uint32_t p = pixels; pixels = 0; return p; };
+	static inline uint32_t takeDropped() { uint32_t d = dropped; dropped = 0; return d; };
+
+private:
+	static comp_item_t *add( int type, color_t color );
+	static void damage( comp_rect_t r );
+	static void measure( comp_item_t &it, const comp_scene_t &s );
+	static void render( const comp_item_t &it, const comp_scene_t &s );
+	static void draw( const comp_rect_t &r );
+	static eglib_t tile;
+	static tile_config_t tile_config;
+	static pixel_t buffer[COMP_TILE_PIXELS];
+	static color_t background;
+	static int width, height;
+	static comp_scene_t scene[2];
+	static int cur;                // scene built this frame, the other one is on screen
+	static bool invalid;
+	static bool renew;
+	static comp_rect_t dmg[COMP_DAMAGE];
+	static int num_dmg;
+	static uint32_t rects;
+	static uint32_t pixels;
+	static uint32_t dropped;       // primitives beyond COMP_PRIMS or COMP_TEXTS
+};
+
+#endif /* MAIN_COMPOSITOR_H_ */
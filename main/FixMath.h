@@ -0,0 +1,123 @@
+/*
+ * FixMath.h
+ *
+ * Integer replacements for the libm calls of the per target update. The
+ * ESP32-S2 has no FPU, every sin, atan2, sqrt or log goes through the soft
+ * float (D2R even through double) library.
+ *
+ * Angles are binary angles: 65536 per full turn in an uint16_t, so
+ * wrap around is free and the difference of two angles, taken as int16_t,
+ * is already normalized to -180..180 degrees. sin/cos come from a quarter
+ * wave table with linear interpolation (Q15), atan2 from an octant reduced
+ * atan table, sqrt is the bitwise integer root.
+ *
+ * Kept free of ESP-IDF includes, so it can be compiled on the host too,
+ * the tables are in FixMath.cpp.
+ */
+
+#ifndef MAIN_FIXMATH_H_
+#define MAIN_FIXMATH_H_
+
+#include <cstdint>
+
+typedef uint16_t bangle_t;
+
+#define BANGLE_90   16384
+#define BANGLE_120  21845
+#define FIX_ONE     32768   // Q15 1.0, results of fixSin()/fixCos() are within +-32767
+
+extern const int16_t fix_sin_lut[257];    // sin over a quarter turn, Q15
+extern const uint16_t fix_atan_lut[257];  // atan( i/256 ) as bangle_t
+extern const uint32_t fix_log2_lut[65];   // log2( 1 + i/64 ), Q16
+
+// 1/100 degree (GPRMC course), 65536/36000 as 29826/16384
+inline bangle_t bangleFromCentiDeg( int cdeg ) {
+	return (bangle_t)((cdeg * 29826 + 8192) >> 14);
+}
+
+inline bangle_t bangleFromDeg( float deg ) {
+	return (bangle_t)(int32_t)(deg * (65536.0f/360.0f) + (deg < 0 ? -0.5f : 0.5f));
+}
+
+// -180..180 degrees
+inline float bangleToDeg( int16_t a ) {
+	return a * (360.0f/65536.0f);
+}
+
+// sin of a quarter turn position 0..BANGLE_90
+inline int fixSinQ( int a ) {
+	int i = a >> 6;
+	int f = a & 63;
+	int v = fix_sin_lut[i];
+	if( f )
+		v += ((fix_sin_lut[i+1] - v) * f) >> 6;
+	return v;
+}
+
+inline int fixSin( bangle_t a ) {
+	int q = a & (BANGLE_90-1);
+	switch( a >> 14 ){
+	case 0:  return fixSinQ( q );
+	case 1:  return fixSinQ( BANGLE_90 - q );
+	case 2:  return -fixSinQ( q );
+	default: return -fixSinQ( BANGLE_90 - q );
+	}
+}
+
+inline int fixCos( bangle_t a ) {
+	return fixSin( (bangle_t)(a + BANGLE_90) );
+}
+
+// v * sin or cos, rounded to an integer
+inline int fixMul( int v, int q15 ) {
+	return (v * q15 + FIX_ONE/2) >> 15;
+}
+
+// angle of (x, y) counted from the x axis towards y, e.g. atan2( east, north ) as bearing, |x|,|y| < 65536
+inline bangle_t fixAtan2( int y, int x ) {
+	uint32_t ax = x < 0 ? -x : x;
+	uint32_t ay = y < 0 ? -y : y;
+	if( !ax && !ay )
+		return 0;
+	bool steep = ay > ax;
+	uint32_t q = steep ? (ax << 16) / ay : (ay << 16) / ax;   // ratio 0..1 in Q16
+	uint32_t i = q >> 8;
+	uint32_t f = q & 255;
+	uint32_t a = fix_atan_lut[i];
+	if( f )
+		a += ((fix_atan_lut[i+1] - a) * f) >> 8;
+	if( steep )
+		a = BANGLE_90 - a;
+	if( x < 0 )
+		a = 2*BANGLE_90 - a;
+	return (bangle_t)(y < 0 ? -a : a);
+}
+
+inline uint32_t fixSqrt( uint32_t v ) {
+	uint32_t r = 0;
+	uint32_t bit = 1u << 30;
+	while( bit > v )
+		bit >>= 2;
+	while( bit ){
+		if( v >= r + bit ){
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else
+			r >>= 1;
+		bit >>= 2;
+	}
+	return r;
+}
+
+// natural logarithm in Q16, v >= 1
+inline int fixLn( uint32_t v ) {
+	int e = 31 - __builtin_clz( v );
+	uint32_t m = (v << (31 - e)) & 0x7FFFFFFF;   // mantissa behind the leading one, Q31
+	uint32_t i = m >> 25;
+	uint32_t f = (m >> 9) & 0xFFFF;
+	uint32_t l2 = (e << 16) + fix_log2_lut[i] + (((fix_log2_lut[i+1] - fix_log2_lut[i]) * f) >> 16);
+	return ((uint64_t)l2 * 45426) >> 16;   // * ln(2)
+}
+
+#endif /* MAIN_FIXMATH_H_ */
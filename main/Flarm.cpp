@@ -4,8 +4,7 @@
 #include "math.h"
 #include "pflaa2.h"
 #include "TargetManager.h"
-#include <iostream>
-#include <sstream>
+#include "Serial.h"
 
 #define TASK_PERIOD 1000  // ms
 
@@ -25,8 +24,8 @@ int Flarm::RelativeBearing = 0;
 int Flarm::AlarmType = 0;
 int Flarm::RelativeVertical = 0;
 int Flarm::RelativeDistance = 0;
-float Flarm::gndSpeedKnots = 0;
-float Flarm::gndCourse = 0;
+int Flarm::gndSpeedKnots = 0;
+int Flarm::gndCourse = 0;
 bool Flarm::myGPS_OK = false;
 bool Flarm::_connected = true;
 char Flarm::ID[20] = "";
@@ -115,6 +114,23 @@ static std::map<int, const char*> FlarmErrors = {
 		{ 0xF1, "Other" },
 };
 
+// sentence tag -> parser, register new FLARM sentences here
+static const struct {
+	const char *tag;
+	nmea_handler_t handler;
+} flarm_sentences[] = {
+		{ "PFLAU", Flarm::parsePFLAU },
+		{ "PFLAA", Flarm::parsePFLAA },
+		{ "GPRMC", Flarm::parseGPRMC },   // GNRMC too, talker is folded
+		{ "GPGGA", Flarm::parseGPGGA },
+		{ "PGRMZ", Flarm::parsePGRMZ },
+		{ "PFLAV", Flarm::parsePFLAV },
+		{ "PFLAE", Flarm::parsePFLAE },   // On Task declaration or re-connect
+		{ "PFLAQ", Flarm::parsePFLAQ },
+};
+
+static NMEADispatcher sentences;
+
 const char * Flarm::getErrorString( int index ) {
 	ESP_LOGI(FNAME," index: %d find: %d", index, FlarmErrors.count( index ) );
 	if( FlarmErrors.count( index ) )
@@ -124,15 +140,20 @@ const char * Flarm::getErrorString( int index ) {
 }
 
 void Flarm::begin(){
+	for( const auto &s : flarm_sentences )
+		sentences.add( nmeaTag( s.tag ), s.handler );
 	xTaskCreatePinnedToCore(&taskFlarm, "taskFlarm", 4096, NULL, 14, &pid, 0);
 }
 
 void Flarm::taskFlarm(void *pvParameters)
 {
+	int stats_tick = 0;
 	while(1){
 		progress();
 		delay(TASK_PERIOD);
 		_tick++;
+		if( !(++stats_tick % 300) )  // every 5 minutes
+			dumpSentenceStats();
 	}
 }
 
@@ -144,7 +165,7 @@ $PFLAA,0,-1234,1234,220,2,DD8F12,180,,30,-1.4,1*
  */
 
 
-void Flarm::parsePFLAA( const char *pflaa ){
+void Flarm::parsePFLAA( const nmea_frame_t &pflaa ){
 	// ESP_LOGI(FNAME,"PFLAA %s", pflaa );
 	/*
 	http://delta-omega.com/download/EDIA/FLARM_DataportManual_v3.02E.pdf
@@ -208,53 +229,11 @@ void Flarm::parsePFLAA( const char *pflaa ){
 					D = UAV
 					F = static
 	 */
-	int cs;
 	nmea_pflaa_s PFLAA;
 	memset( &PFLAA, 0, sizeof(PFLAA) );
-	int calc_cs=calcNMEACheckSum( pflaa );
-	cs = getNMEACheckSum( pflaa );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"PFLAA CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", pflaa, calc_cs, cs );
-		return;
-	}
 	// PFLAA,<AlarmLevel>,<RelativeNorth>,<RelativeEast>,<RelativeVertical>,<IDType>,<ID>,<Track>,<TurnRate>,<GroundSpeed>,<ClimbRate>,<Type>
-
-	std::istringstream ss(pflaa);
-	std::string token;
-	std::getline(ss, token, ',');
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.alarmLevel = std::stoi(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.relNorth = std::stoi(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.relEast = std::stoi(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.relVertical = std::stoi(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.idType = std::stoi(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		sscanf(token.c_str(),"%06X", &PFLAA.ID );
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.track = std::stoi(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.turnRate = std::stof(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.groundSpeed = std::stof(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		PFLAA.climbRate = std::stof(token);
-	std::getline(ss, token, ',');
-	if( !token.empty() )
-		sscanf(token.c_str(), "%2s", PFLAA.acftType);
+	// walk fields in place, no heap, empty (privacy) fields stay zero
+	decodePFLAA( pflaa, PFLAA );
 
 	_tick=0;
 	connected_timeout = FLARM_TIMEOUT;
@@ -263,34 +242,14 @@ void Flarm::parsePFLAA( const char *pflaa ){
 
 
 
-// Calculate the checksum and output it as an int
-// is required as HEX in the NMEA data set
-// between $ or! and * character
-int Flarm::calcNMEACheckSum(const char *nmea) {
-	int i, XOR, c;
-	for (XOR = 0, i = 0; i < strlen(nmea); i++) {
-		c = (unsigned char)nmea[i];
-		if (c == '*') break;
-		if ((c != '$') && (c != '!')) XOR ^= c;
-	}
-	return XOR;
-}
-
-int Flarm::getNMEACheckSum(const char *nmea) {
-    const char *p = strchr(nmea, '*');
-    if (!p) return -1;
-    int cs = 0;
-    if (sscanf(p, "*%02x", &cs) != 1) return -1;
-    return cs;
-}
-
-
 void Flarm::flarmSim() {
     // ESP_LOGI(FNAME, "flarmSim sim-tick: %d", sim_tick);
+    static NMEAFramer sim_framer;
     if (sim_tick >= 0 && sim_tick < END_SIM) {
-        char str[80];
-        snprintf(str, sizeof(str), "%s", pflaa2[sim_tick]);
-        parseNMEA(str, strlen(str));
+        for( const char *c = pflaa2[sim_tick]; *c; c++ ){
+            if( sim_framer.feed( c ) )
+                parseNMEA( sim_framer.frame() );
+        }
         sim_tick++;
     } else {
         flarm_sim = false;   // end sim mode
@@ -348,32 +307,21 @@ void Flarm::progress(){  //  per second
 }
 
 
-void Flarm::parseNMEA( const char *str, int len ){
-	// ESP_LOGI(FNAME,"parseNMEA: %s, len: %d", str,  strlen(str) );
-	if( !strncmp( str+1, "PFLAU,", 5 )) {
-		parsePFLAU( str );
-	}
-	else if( !strncmp( str+1, "PFLAA,", 5 )) {
-		parsePFLAA( str );
-	}
-	else if( !strncmp( str+3, "RMC,", 3 ) ) {
-		parseGPRMC( str );
-	}
-	else if( !strncmp( str+3, "GGA,", 3 )) {
-		parseGPGGA( str );
-	}
-	else if( !strncmp( str+3, "RMZ,", 3 )) {
-		parsePGRMZ( str );
-	}
-	else if( !strncmp( str+1, "PFLAV,", 5 )) {
-		parsePFLAV( str );
-	}
-	else if( !strncmp( str+1, "PFLAE,", 5 )) {  // On Task declaration or re-connect
-		parsePFLAE( str );
-	}
-	else if( !strncmp( str+1, "PFLAQ,", 5 )) {
-		parsePFLAQ( str );
+// frames arrive checksum validated and field indexed from NMEAFramer
+void Flarm::parseNMEA( const nmea_frame_t &frame ){
+	// ESP_LOGI(FNAME,"parseNMEA: %.*s, len: %d", frame.len, frame.sentence, frame.len );
+	sentences.dispatch( frame );
+}
+
+void Flarm::dumpSentenceStats(){
+	for( const auto &s : flarm_sentences ){
+		nmea_sentence_t *e = sentences.find( nmeaTag( s.tag ) );
+		if( e && e->count )
+			ESP_LOGI(FNAME,"NMEA %s: %u", s.tag, e->count );
 	}
+	ESP_LOGI(FNAME,"NMEA unknown: %u, bad checksum: %u, overflow: %u", sentences.getUnknown(), Serial::getBadChecksum(), Serial::getOverflow() );
+	Serial::dumpStats();
+	ESP_LOGI(FNAME,"Traffic queue high water: %u, overflow: %u", TargetManager::getQueueHighWater(), TargetManager::getQueueOverflow() );
 }
 
 
@@ -394,33 +342,27 @@ eg2. $GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191194,020.3,E*68
 
 
  */
-void Flarm::parseGPRMC( const char *gprmc ) {
+void Flarm::parseGPRMC( const nmea_frame_t &gprmc ) {
 	char warn;
-	int cs;
-	int calc_cs=calcNMEACheckSum( gprmc );
-	cs = getNMEACheckSum( gprmc );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", gprmc, calc_cs, cs );
-		return;
-	}
-	sscanf( gprmc+3, "RMC,%*f,%c,%*f,%*c,%*f,%*c,%f,%f,%*d,%*f,%*c*%*02x", &warn, &gndSpeedKnots, &gndCourse);
+	warn = 0;
+	decodeGPRMC( gprmc, warn, gndSpeedKnots, gndCourse );  // fixed point, no soft-float scanf
 
 	//ESP_LOGI(FNAME,"GPRMC myGPS_OK %d warn %c", myGPS_OK, warn );
 	if( warn == 'A' ) {
 		if( myGPS_OK == false ){
 			myGPS_OK = true;
-			ESP_LOGI(FNAME,"GPRMC, GPS status changed to good, rmc:%s gps:%d", gprmc, myGPS_OK );
+			ESP_LOGI(FNAME,"GPRMC, GPS status changed to good, rmc:%.*s gps:%d", gprmc.end, gprmc.sentence, myGPS_OK );
 		}
 		// ESP_LOGI(FNAME,"Track: %3.2f, GPRMC: %s", gndCourse, gprmc );
 	}
 	else{
 		if( myGPS_OK == true  ){
 			myGPS_OK = false;
-			ESP_LOGI(FNAME,"GPRMC, GPS status changed to bad, rmc:%s gps:%d", gprmc, myGPS_OK );
+			ESP_LOGI(FNAME,"GPRMC, GPS status changed to bad, rmc:%.*s gps:%d", gprmc.end, gprmc.sentence, myGPS_OK );
 		}
 	}
 	connected_timeout =FLARM_TIMEOUT;
-	// ESP_LOGI(FNAME,"parseGPRMC() GPS: %d, Speed: %3.1f knots, Track: %3.1f° ", myGPS_OK, gndSpeedKnots, gndCourse );
+	// ESP_LOGI(FNAME,"parseGPRMC() GPS: %d, Speed: %d centi knots, Track: %d centi deg", myGPS_OK, gndSpeedKnots, gndCourse );
 }
 
 /*
@@ -446,20 +388,16 @@ eg. $GPGGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,x,xx,x.x,x.x,M,x.x,M,x.x,xxxx*hh
  */
 
 
-void Flarm::parseGPGGA( const char *gpgga ) {
+void Flarm::parseGPGGA( const nmea_frame_t &gpgga ) {
 	// ESP_LOGI(FNAME,"parseGPGGA");
 	int numSat;
-	int cs;
 	// ESP_LOGI(FNAME,"parseG*GGA: %s", gpgga );
-	int calc_cs=calcNMEACheckSum( gpgga );
-	cs = getNMEACheckSum( gpgga );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", gpgga, calc_cs, cs );
-		return;
-	}
-	int ret=sscanf( gpgga+3, "GGA,%*f,%*f,%*c,%*f,%*c,%*d,%d,%*f,%*f,M,%*f,M,%*f,%*d*%*02x", &numSat);
-	// ESP_LOGI(FNAME,"parseG*GGA: %s numSat=%d ssf_ret=%d", gpgga, numSat, ret );
-	if( ret >=1 ){
+	NMEAReader r( gpgga );
+	for( int i=0; i<6; i++ )  // time, lat, N/S, lon, E/W, quality
+		r.skip();
+	bool ret = r.nextInt( numSat );
+	// ESP_LOGI(FNAME,"parseG*GGA: %s numSat=%d ret=%d", gpgga, numSat, ret );
+	if( ret ){
 		if( numSat != _numSat ){
 			_numSat = numSat;
 		}
@@ -470,23 +408,21 @@ void Flarm::parseGPGGA( const char *gpgga ) {
 // parsePFLAE $PFLAE,A,0,0*33   $PFLAE,A,2,2A,XPDR receiver*79
 // PFLAE,<QueryType>,<Severity>,<ErrorCode>[,<Message>]
 
-void Flarm::parsePFLAE( const char *pflae ) {
-	ESP_LOGI(FNAME,"parsePFLAE %s", pflae );
-	int cs;
-	int calc_cs=calcNMEACheckSum( pflae );
-	cs = getNMEACheckSum( pflae );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", pflae, calc_cs, cs );
-		return;
-	}
+void Flarm::parsePFLAE( const nmea_frame_t &pflae ) {
+	ESP_LOGI(FNAME,"parsePFLAE %.*s", pflae.end, pflae.sentence );
 	connected_timeout =FLARM_TIMEOUT;
-	char queryType;
-	int ret=sscanf( pflae+3,"LAE,%c,%d,%x", &queryType, &pflae_severity, &pflae_error );
+	char queryType = 0;
+	unsigned int error = 0;
+	NMEAReader r( pflae );
+	int ret = r.nextChar( queryType );
+	ret += r.nextInt( pflae_severity );
+	ret += r.nextHex( error );
+	pflae_error = error;
 	if( queryType == 'A' && ret == 3 ){
 			ESP_LOGI(FNAME,"PFLAE ret:%d, QT:%c SV:%d EC:%02X MSG:%s", ret, queryType, pflae_severity, pflae_error, getErrorString(pflae_error) );
 			flags.error=true;
 	}else
-		ESP_LOGW(FNAME,"Ignored PFLAE Query or wrong format: <%s>", pflae );
+		ESP_LOGW(FNAME,"Ignored PFLAE Query or wrong format: <%.*s>", pflae.end, pflae.sentence );
 }
 
 /* PFLAU,<RX>,<TX>,<GPS>,<Power>,<AlarmLevel>,<RelativeBearing>,<AlarmType>,<RelativeVertical>,<RelativeDistance>,<ID>
@@ -530,17 +466,20 @@ E = unknown
 F = static object
  */
 
-void Flarm::parsePFLAU( const char *pflau, bool sim_data ) {
+void Flarm::parsePFLAU( const nmea_frame_t &pflau ) {
 	// ESP_LOGI(FNAME,"parsePFLAU");
-	int cs;
-	int id;
-	int calc_cs=calcNMEACheckSum( pflau );
-	cs = getNMEACheckSum( pflau );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", pflau, calc_cs, cs );
-		return;
-	}
-	sscanf( pflau, "$PFLAU,%d,%d,%d,%d,%d,%d,%d,%d,%d,%x*%02x",&RX,&TX,&GPS,&Power,&AlarmLevel,&RelativeBearing,&AlarmType,&RelativeVertical,&RelativeDistance,&id,&cs);
+	unsigned int id = 0;
+	NMEAReader r( pflau );
+	r.nextInt( RX );
+	r.nextInt( TX );
+	r.nextInt( GPS );
+	r.nextInt( Power );
+	r.nextInt( AlarmLevel );
+	r.nextInt( RelativeBearing );
+	r.nextInt( AlarmType );
+	r.nextInt( RelativeVertical );
+	r.nextInt( RelativeDistance );
+	r.nextHex( id );
 	// ESP_LOGI(FNAME,"parsePFLAU() RB: %d ALT:%d  DIST %d",RelativeBearing,RelativeVertical, RelativeDistance );
 	sprintf( ID,"%06x", id );
 	_tick=0;
@@ -586,33 +525,24 @@ void Flarm::parsePFLAX( const char *msg, int port ) {
 }
 
 // $PGRMZ,880,F,2*3A  $PGRMZ,864,F,2*30
-void Flarm::parsePGRMZ( const char *pgrmz ) {
-	int cs;
+void Flarm::parsePGRMZ( const nmea_frame_t &pgrmz ) {
 	int alt1013_ft;
-	int calc_cs=calcNMEACheckSum( pgrmz );
-	cs = getNMEACheckSum( pgrmz );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", pgrmz, calc_cs, cs );
-		return;
-	}
-	sscanf( pgrmz, "$PGRMZ,%d,F,2",&alt1013_ft );
+	NMEAReader r( pgrmz );
+	r.nextInt( alt1013_ft );
 	connected_timeout =FLARM_TIMEOUT;
 	ext_alt_timer = 10;  // Fall back to internal Barometer after 10 seconds
 }
 
 // PFLAV,<QueryType>,<HwVersion>,<SwVersion>,<ObstVersion>
 // e.g. $PFLAV,A,2.00,5.00,alps20110221_*
-void Flarm::parsePFLAV( const char *pflav ) {
-	ESP_LOGI(FNAME,"parse %s", pflav );
-	int cs;
-	int calc_cs=calcNMEACheckSum( pflav );
-	cs = getNMEACheckSum( pflav );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", pflav, calc_cs, cs );
-		return;
-	}
-	char query;
-	sscanf( pflav, "$PFLAV,%c,%15[^,],%15[^,],%31[^,]", &query, HwVersion, SwVersion, ObstVersion );
+void Flarm::parsePFLAV( const nmea_frame_t &pflav ) {
+	ESP_LOGI(FNAME,"parse %.*s", pflav.end, pflav.sentence );
+	char query = 0;
+	NMEAReader r( pflav );
+	r.nextChar( query );
+	r.nextChars( HwVersion, sizeof(HwVersion)-1 );
+	r.nextChars( SwVersion, sizeof(SwVersion)-1 );
+	bool odb = r.nextChars( ObstVersion, sizeof(ObstVersion)-1 );
 
 	if( query == 'A' ){
 		ESP_LOGI(FNAME,"PFLAV %c %s %s %s", query, HwVersion,SwVersion,ObstVersion );
@@ -620,8 +550,7 @@ void Flarm::parsePFLAV( const char *pflav ) {
 		flags.hwVersion=true;
 		flags.odbVersion=true;
 	}
-	if( ObstVersion[0] == '*' ){ // there is no obstacle database
-		ObstVersion[0] = '\0';
+	if( !odb ){ // there is no obstacle database
 		flags.odbVersion=false;
 	}
 
@@ -650,28 +579,23 @@ const char* Flarm::getOperationString(const char *key) {
 }
 
 // PFLAQ,<Operation>,<Info>,<Progress>
-void Flarm::parsePFLAQ( const char *pflaq ) {
-	ESP_LOGI(FNAME,"PFLAQ %s", pflaq );
-	int cs;
-	int calc_cs=calcNMEACheckSum( pflaq );
-	cs = getNMEACheckSum( pflaq );
+void Flarm::parsePFLAQ( const nmea_frame_t &pflaq ) {
+	ESP_LOGI(FNAME,"PFLAQ %.*s", pflaq.end, pflaq.sentence );
 	memset( Operation, 0, sizeof( Operation ) );
-	if( cs != calc_cs ){
-		ESP_LOGW(FNAME,"CHECKSUM ERROR: %s; calculcated CS: %d != delivered CS %d", pflaq, calc_cs, cs );
-		return;
-	}
-	int commas=0;
-	for( int i=0; i<strlen(pflaq); i++ ){
-		if( pflaq[i] == ',' )
-			commas++;
-	}
+	int commas = pflaq.nfields - 1;
+	int progress = 0;
+	NMEAReader r( pflaq );
+	r.nextChars( Operation, sizeof(Operation)-1 );
 	if( commas == 2 ){
-		sscanf( pflaq, "$PFLAQ,%[^,],%d",Operation,&Progress );
+		r.nextInt( progress );
+		Progress = progress;
 		ESP_LOGI(FNAME,"2 PFLAQ %s %d", Operation, Progress );
 		ESP_LOGI(FNAME,"2 PFLAQ %s %d %s", Operation, Progress, getOperationString(Operation) );
 	}
 	else if( commas == 3 ){
-		sscanf( pflaq, "$PFLAQ,%[^,],%[^,],%d",Operation,Info,&Progress );
+		r.nextChars( Info, sizeof(Info)-1 );
+		r.nextInt( progress );
+		Progress = progress;
 		ESP_LOGI(FNAME,"3 PFLAQ %s %s %d", Operation, Info, Progress );
 	    // ESP_LOGI(FNAME,"3 PFLAQ %s %s %d %s", Operation,Info,Progress, getOperationString[Operation] );
 	}
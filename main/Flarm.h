@@ -6,24 +6,12 @@
 #include <AdaptUGC.h>
 #include "RingBufCPP.h"  // SString, tbd: extra header
 #include "Units.h"
+#include "NMEA.h"
 #include "freertos/FreeRTOS.h"
 #include <map>
 
 typedef enum e_audio_alarm_type { AUDIO_ALARM_OFF, AUDIO_ALARM_NEAR, AUDIO_ALARM_FLARM_1, AUDIO_ALARM_FLARM_2, AUDIO_ALARM_FLARM_3  } e_audio_alarm_type_t;
 
-typedef struct {
-	int alarmLevel;
-	int relNorth;
-	int relEast;
-	int relVertical;
-	int idType;
-	unsigned int ID;
-	int track;
-	float turnRate;
-	float groundSpeed;
-	float climbRate;
-	char acftType[3];
-} nmea_pflaa_s;
 
 typedef struct flarm_flags{
 	bool error;
@@ -56,16 +44,17 @@ typedef struct flarm_flags{
 class Flarm {
 public:
 	static void setDisplay( AdaptUGC *theUcg ) { ucg = theUcg; };
-	static void parseNMEA( const char *str, int len );
-	static void parsePFLAE( const char *pflae );
-	static void parsePFLAU( const char *pflau, bool sim=false );
-	static void parsePFLAA( const char *pflaa );
-	static void parsePFLAV( const char* pflav );
+	static void parseNMEA( const nmea_frame_t &frame );
+	static void dumpSentenceStats();
+	static void parsePFLAE( const nmea_frame_t &pflae );
+	static void parsePFLAU( const nmea_frame_t &pflau );
+	static void parsePFLAA( const nmea_frame_t &pflaa );
+	static void parsePFLAV( const nmea_frame_t &pflav );
 	static void parsePFLAX( const char *pflax, int port );
-	static void parsePFLAQ( const char *pflaq );
-	static void parseGPRMC( const char *gprmc );
-	static void parseGPGGA( const char *gpgga );
-	static void parsePGRMZ( const char *pgrmz );
+	static void parsePFLAQ( const nmea_frame_t &pflaq );
+	static void parseGPRMC( const nmea_frame_t &gprmc );
+	static void parseGPGGA( const nmea_frame_t &gpgga );
+	static void parsePGRMZ( const nmea_frame_t &pgrmz );
 	static void drawAirplane( int x, int y, bool fromBehind=false, bool smallSize=false );
 	static inline int alarmLevel(){ return AlarmLevel; };
 	// static void drawDownloadInfo();
@@ -73,8 +62,8 @@ public:
 	static bool connected() { return _connected; };     // returns true if Flarm is connected
 	static inline bool getGPS( float &gndSpeedKmh, float &gndTrack ) {
 		if( myGPS_OK ) {
-			gndSpeedKmh = Units::knots2kmh(gndSpeedKnots);
-			gndTrack = gndCourse;
+			gndSpeedKmh = Units::knots2kmh(gndSpeedKnots/(float)NMEA_CENTI);
+			gndTrack = gndCourse/(float)NMEA_CENTI;
 			return true;
 		}
 		else{
@@ -83,7 +72,7 @@ public:
 	}
 	static inline bool getGPSknots( float &gndSpeed ) {
 			if( myGPS_OK ) {
-				gndSpeed = gndSpeedKnots;
+				gndSpeed = gndSpeedKnots/(float)NMEA_CENTI;
 				return true;
 			}
 			else{
@@ -91,8 +80,10 @@ public:
 			}
 	}
 	static inline bool gpsStatus() { return myGPS_OK; }
-	static float getGndSpeedKnots() { return gndSpeedKnots; }
-	static inline float getGndCourse() { return gndCourse; }
+	static float getGndSpeedKnots() { return gndSpeedKnots/(float)NMEA_CENTI; }
+	static inline float getGndCourse() { return gndCourse/(float)NMEA_CENTI; }
+	static inline int getGndSpeedCentiKnots() { return gndSpeedKnots; }   // 1/100 knots
+	static inline int getGndCourseCenti() { return gndCourse; }            // 1/100 deg
 	static int bincom;
 	static int bincom_port;
 	static void tick();
@@ -137,9 +128,6 @@ public:
 	static inline void resetConnectedFlag() {  flags.connected = false; };
 
 private:
-	static int calcNMEACheckSum(const char *nmea);
-	static int getNMEACheckSum(const char *nmea);
-
 	static void flarmSim();
 	static void pflau_timeout();
 
@@ -149,8 +137,8 @@ private:
 	static int last_RX,last_TX,last_GPS;
 	static int AlarmLevel;
 	static int RelativeBearing,RelativeVertical,RelativeDistance;
-	static float gndSpeedKnots;
-	static float gndCourse;
+	static int gndSpeedKnots;   // 1/100 knots
+	static int gndCourse;       // 1/100 deg
 	static bool  myGPS_OK;
 	static bool _connected;
 	static int AlarmType;
@@ -0,0 +1,153 @@
+/*
+ * Flarmnet.cpp
+ *
+ */
+
+#include <cstring>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include "logdef.h"
+#include "Flarmnet.h"
+
+#define FLASH_SECTOR 4096
+
+const esp_partition_t *Flarmnet::partition = nullptr;
+spi_flash_mmap_handle_t Flarmnet::handle = 0;
+const uint8_t *Flarmnet::base = nullptr;
+flarmnet_header_t Flarmnet::header;
+int Flarmnet::num = 0;
+SemaphoreHandle_t Flarmnet::mutex = nullptr;
+flarmnet_header_t Flarmnet::update;
+uint32_t Flarmnet::written = 0;
+uint32_t Flarmnet::erased = 0;
+uint32_t Flarmnet::crc = 0;
+
+bool Flarmnet::begin(){
+	mutex = xSemaphoreCreateMutex();
+	partition = esp_partition_find_first( ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)FLARMNET_PARTITION_SUBTYPE, "flarmnet" );
+	if( !partition ){
+		ESP_LOGE(FNAME,"No flarmnet partition, the partition table is older than the firmware: flash over USB once");
+		return false;
+	}
+	if( !open() ){
+		ESP_LOGE(FNAME,"No valid flarmnet database: flash flarmnet.bin over USB or POST it to /flarmnet");
+		return false;
+	}
+	return true;
+}
+
+// map the partition and check the database, lookups are enabled on success
+bool Flarmnet::open(){
+	if( esp_partition_read( partition, 0, &header, sizeof(header) ) != ESP_OK || !flarmnetHeaderValid( header, partition->size ) ){
+		ESP_LOGW(FNAME,"No flarmnet database in partition at 0x%x", partition->address );
+		return false;
+	}
+	const void *p;
+	if( esp_partition_mmap( partition, 0, header.size, SPI_FLASH_MMAP_DATA, &p, &handle ) != ESP_OK ){
+		ESP_LOGE(FNAME,"Mapping flarmnet partition failed");
+		return false;
+	}
+	int64_t start = esp_timer_get_time();
+	const uint8_t *data = (const uint8_t *)p;
+	if( esp_rom_crc32_le( 0, data + header.header_len, header.size - header.header_len ) != header.crc ){
+		ESP_LOGE(FNAME,"Flarmnet database CRC error");
+		spi_flash_munmap( handle );
+		return false;
+	}
+	base = data;
+	num = header.count;
+	ESP_LOGI(FNAME,"Flarmnet %s: %d entries, %d bytes, CRC checked in %d us", header.version, num, header.size, (int)(esp_timer_get_time() - start) );
+	return true;
+}
+
+void Flarmnet::close(){
+	if( !base )
+		return;
+	num = 0;
+	base = nullptr;
+	spi_flash_munmap( handle );
+}
+
+bool Flarmnet::find( uint32_t id, char *reg, char *cn ){
+	if( !num || xSemaphoreTake( mutex, 0 ) != pdTRUE )   // no database or update in progress
+		return false;
+	bool found = false;
+	if( base ){
+		int i = flarmnetFind( base + header.ids, num, id );
+		if( i >= 0 )
+			found = flarmnetStrings( base, header, i, reg, cn );
+	}
+	xSemaphoreGive( mutex );
+	return found;
+}
+
+bool Flarmnet::beginUpdate( const flarmnet_header_t &h ){
+	if( !partition || !mutex ){
+		ESP_LOGE(FNAME,"No flarmnet partition");
+		return false;
+	}
+	if( !flarmnetHeaderValid( h, partition->size ) ){
+		ESP_LOGE(FNAME,"Invalid flarmnet header, size %d, partition %d", h.size, partition->size );
+		return false;
+	}
+	xSemaphoreTake( mutex, portMAX_DELAY );
+	close();
+	// the sector with the header only, the old database is invalid from here on,
+	// the others are erased by writeUpdate() as the data arrives
+	if( esp_partition_erase_range( partition, 0, FLASH_SECTOR ) != ESP_OK ){
+		ESP_LOGE(FNAME,"Erasing flarmnet partition failed");
+		xSemaphoreGive( mutex );
+		return false;
+	}
+	erased = FLASH_SECTOR;
+	update = h;
+	written = h.header_len;
+	crc = 0;
+	ESP_LOGI(FNAME,"Flarmnet update %s: %d entries, %d bytes", h.version, h.count, h.size );
+	return true;
+}
+
+bool Flarmnet::writeUpdate( const void *data, size_t len ){
+	if( written + len > update.size ){
+		ESP_LOGE(FNAME,"Flarmnet update exceeds %d bytes", update.size );
+		return false;
+	}
+	while( erased < written + len ){
+		if( esp_partition_erase_range( partition, erased, FLASH_SECTOR ) != ESP_OK ){
+			ESP_LOGE(FNAME,"Erasing flarmnet sector at %d failed", erased );
+			return false;
+		}
+		erased += FLASH_SECTOR;
+	}
+	if( esp_partition_write( partition, written, data, len ) != ESP_OK ){
+		ESP_LOGE(FNAME,"Flarmnet write at %d failed", written );
+		return false;
+	}
+	crc = esp_rom_crc32_le( crc, (const uint8_t *)data, len );
+	written += len;
+	return true;
+}
+
+// the header goes in last, only once the body is complete and matches the CRC
+bool Flarmnet::endUpdate(){
+	bool ok = false;
+	if( written != update.size )
+		ESP_LOGE(FNAME,"Flarmnet update incomplete: %d of %d bytes", written, update.size );
+	else if( crc != update.crc )
+		ESP_LOGE(FNAME,"Flarmnet update CRC mismatch: %08x, expected %08x", crc, update.crc );
+	else if( esp_partition_write( partition, 0, &update, sizeof(update) ) != ESP_OK )
+		ESP_LOGE(FNAME,"Flarmnet header write failed");
+	else
+		ok = open();
+	update.size = 0;
+	xSemaphoreGive( mutex );
+	return ok;
+}
+
+// the header was not written, the partition stays without a valid database
+void Flarmnet::abortUpdate(){
+	ESP_LOGW(FNAME,"Flarmnet update aborted after %d bytes", written );
+	update.size = 0;
+	xSemaphoreGive( mutex );
+}
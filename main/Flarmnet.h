@@ -0,0 +1,60 @@
+/*
+ * Flarmnet.h
+ *
+ * Flarmnet database in its own data partition (see partitions.csv), memory
+ * mapped, so lookups read the flash directly without a copy in RAM and the
+ * database is not part of the app images.
+ *
+ * flarmnet.bin is flashed with the app by "idf.py flash" and flash-bin. A unit
+ * updated by OTA from a firmware before the flarmnet partition keeps its old
+ * partition table without it, it must be flashed over USB once.
+ *
+ * The database can be replaced over Wi-Fi (cWebserver, POST /flarmnet):
+ * beginUpdate() erases the header sector, writeUpdate() erases the sectors
+ * ahead of the data and streams the body behind the header, endUpdate()
+ * checks size and CRC and writes the header last.
+ * Lookups fail while an update is in progress.
+ */
+
+#ifndef MAIN_FLARMNET_H_
+#define MAIN_FLARMNET_H_
+
+#include <cstddef>
+#include <esp_partition.h>
+#include <esp_spi_flash.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "flarmnet.h"
+
+#define FLARMNET_PARTITION_SUBTYPE 0x40
+
+class Flarmnet {
+public:
+	static bool begin();   // false if there is no valid database in the partition
+	// reg needs FLARMNET_REG_LEN bytes, cn FLARMNET_CN_LEN bytes, both unchanged if not found, empty if malformed
+	static bool find( uint32_t id, char *reg, char *cn );
+	static inline int size() { return num; };
+	static inline const char *version() { return num ? header.version : "-"; };
+
+	static bool beginUpdate( const flarmnet_header_t &h );
+	static bool writeUpdate( const void *data, size_t len );
+	static bool endUpdate();
+	static void abortUpdate();
+	static inline int updateProgress() { return update.size ? (written * 100) / update.size : 0; };
+
+private:
+	static bool open();
+	static void close();
+	static const esp_partition_t *partition;
+	static spi_flash_mmap_handle_t handle;
+	static const uint8_t *base;
+	static flarmnet_header_t header;
+	static int num;
+	static SemaphoreHandle_t mutex;    // held by the web server task for the whole update
+	static flarmnet_header_t update;
+	static uint32_t written;
+	static uint32_t erased;            // bytes from the start of the partition
+	static uint32_t crc;
+};
+
+#endif /* MAIN_FLARMNET_H_ */
@@ -0,0 +1,375 @@
+/*
+ * NMEA.h
+ *
+ * Allocation free NMEA ingest. The NMEAFramer scans sentences byte by byte
+ * in the buffer they were received into, computes the XOR checksum on the fly,
+ * validates the *hh trailer and records the offset of every field. Only valid
+ * frames are handed on, so parsers never check or rescan a sentence. A frame
+ * is a view, nothing is copied; the bytes must stay in place until the frame
+ * has been parsed (see rebase() for moving a sentence still being received).
+ *
+ * A NMEAReader converts one field per call directly into the target variable,
+ * using the field offsets of the frame. Empty fields (e.g. PFLAA privacy)
+ * leave the target untouched and return false.
+ *
+ * Decimal values are kept in fixed point, 1/100 of the unit (NMEA_CENTI),
+ * as the ESP32-S2 has no FPU. Conversion to float is left to the display.
+ *
+ * Kept free of ESP-IDF includes, so it can be compiled on the host too.
+ */
+
+#ifndef NMEA_H
+#define NMEA_H
+
+#include <cstdint>
+#include <cstring>
+
+#define NMEA_CENTI 100   // fixed point scale for decimal NMEA values
+
+#define NMEA_FRAME_LEN 512
+#define NMEA_MAX_FIELDS 32
+
+// view of a complete sentence with valid checksum, "$....*hh" plus the line terminator
+typedef struct {
+	const char *sentence;              // not zero terminated, bound by '*'
+	uint16_t len;                      // bytes including the line terminator
+	uint16_t end;                      // offset of '*'
+	uint8_t  nfields;                  // field[0] is the tag
+	uint16_t field[NMEA_MAX_FIELDS];   // offset of the first character of each field
+} nmea_frame_t;
+
+class NMEAFramer {
+public:
+	NMEAFramer() : state(GET_NMEA_SYNC), sum(0), cs(0), cs_digits(0), bad_checksum(0), overflow(0) { fr.sentence = nullptr; };
+
+	// scan the byte at c, returns true when frame() holds a new valid sentence.
+	// All bytes of a sentence must be fed from consecutive addresses.
+	bool feed( const char *c ) {
+		switch( state ){
+		case GET_NMEA_SYNC:
+			if( *c == '$' || *c == '!' ){
+				fr.sentence = c;
+				fr.nfields = 1;
+				fr.field[0] = 1;
+				sum = 0;
+				state = GET_NMEA_STREAM;
+			}
+			break;
+		case GET_NMEA_STREAM:
+			if( *c == '$' || *c == '!' ){   // truncated sentence, start over
+				bad_checksum++;
+				state = GET_NMEA_SYNC;
+				return feed( c );
+			}
+			if( *c == '\r' || *c == '\n' ){  // no checksum, not accepted
+				bad_checksum++;
+				state = GET_NMEA_SYNC;
+				break;
+			}
+			if( *c < 0x20 || *c > 0x7e ){
+				state = GET_NMEA_SYNC;
+				break;
+			}
+			if( c - fr.sentence >= NMEA_FRAME_LEN - 4 ){  // room for "*hh" and terminator
+				overflow++;
+				state = GET_NMEA_SYNC;
+				break;
+			}
+			if( *c == '*' ){
+				fr.end = c - fr.sentence;
+				cs = 0;
+				cs_digits = 0;
+				state = GET_NMEA_CHECKSUM;
+			}
+			else{
+				sum ^= *c;
+				if( *c == ',' && fr.nfields < NMEA_MAX_FIELDS )
+					fr.field[fr.nfields++] = c - fr.sentence + 1;
+			}
+			break;
+		case GET_NMEA_CHECKSUM: {
+			if( *c == '\r' || *c == '\n' ){  // a single terminator is accepted too
+				state = GET_NMEA_SYNC;
+				if( cs_digits != 2 || cs != sum ){
+					bad_checksum++;
+					break;
+				}
+				fr.len = c - fr.sentence + 1;
+				return true;
+			}
+			int v = hexval( *c );
+			if( v < 0 || cs_digits == 2 ){
+				bad_checksum++;
+				state = GET_NMEA_SYNC;
+				break;
+			}
+			cs = (cs << 4) | v;
+			cs_digits++;
+			break;
+		}
+		}
+		return false;
+	};
+
+	// start of the sentence still being received, nullptr if none
+	inline const char *pending() const { return state == GET_NMEA_SYNC ? nullptr : fr.sentence; };
+	// the pending sentence has been moved to to, its offsets stay valid
+	inline void rebase( const char *to ) { fr.sentence = to; };
+
+	inline const nmea_frame_t &frame() const { return fr; };
+	inline uint32_t getBadChecksum() const { return bad_checksum; };
+	inline uint32_t getOverflow() const { return overflow; };
+
+	inline static int hexval( char c ) {
+		if( c >= '0' && c <= '9' ) return c - '0';
+		if( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+		if( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+		return -1;
+	};
+
+private:
+	enum state_t { GET_NMEA_SYNC, GET_NMEA_STREAM, GET_NMEA_CHECKSUM } state;
+	nmea_frame_t fr;
+	uint8_t  sum;
+	uint8_t  cs;
+	uint8_t  cs_digits;
+	uint32_t bad_checksum;
+	uint32_t overflow;
+};
+
+typedef struct {
+	int alarmLevel;
+	int relNorth;
+	int relEast;
+	int relVertical;
+	int idType;
+	unsigned int ID;
+	int track;
+	int turnRate;      // 1/100 deg/s
+	int groundSpeed;   // 1/100 m/s
+	int climbRate;     // 1/100 m/s
+	char acftType[3];
+} nmea_pflaa_s;
+
+class NMEAReader {
+public:
+	// position on data field n of the frame, 1 is the first field behind the tag
+	NMEAReader( const nmea_frame_t &frame, int n=1 ) : f(frame) { seek( n ); };
+
+	inline static bool isEnd( char c ) { return c == ',' || c == '*' || c == '\r' || c == '\n' || c == 0; };
+
+	inline void seek( int n ) {
+		idx = n;
+		p = f.sentence + ((n < f.nfields) ? f.field[n] : f.end);
+	};
+	// continue with the next field
+	inline void skip() { seek( idx+1 ); };
+
+	bool nextInt( int &val ) {
+		const char *s = p;
+		bool neg = false;
+		if( *s == '-' || *s == '+' )
+			neg = (*s++ == '-');
+		if( *s < '0' || *s > '9' ){
+			skip();
+			return false;
+		}
+		int v = 0;
+		while( *s >= '0' && *s <= '9' )
+			v = v*10 + (*s++ - '0');
+		val = neg ? -v : v;
+		skip();
+		return true;
+	};
+
+	bool nextHex( unsigned int &val ) {
+		unsigned int v = 0;
+		int digits = 0;
+		int d;
+		for( const char *s = p; (d = NMEAFramer::hexval( *s )) >= 0; s++ ){
+			v = (v << 4) | d;
+			digits++;
+		}
+		skip();
+		if( !digits )
+			return false;
+		val = v;
+		return true;
+	};
+
+	// signed decimal in 1/100 units, e.g. "-1.4" -> -140, "51.259" -> 5126
+	bool nextCenti( int &val ) {
+		const char *s = p;
+		bool neg = false;
+		if( *s == '-' || *s == '+' )
+			neg = (*s++ == '-');
+		int v = 0;
+		bool digits = false;
+		while( *s >= '0' && *s <= '9' ){
+			v = v*10 + (*s++ - '0');
+			digits = true;
+		}
+		v *= NMEA_CENTI;
+		if( *s == '.' ){
+			s++;
+			int scale = NMEA_CENTI/10;
+			while( *s >= '0' && *s <= '9' ){
+				if( scale > 0 )
+					v += (*s - '0') * scale;
+				else if( scale == 0 && *s >= '5' )
+					v++;     // round on the first dropped digit
+				scale = (scale > 0) ? scale/10 : -1;
+				s++;
+				digits = true;
+			}
+		}
+		skip();
+		if( !digits )
+			return false;
+		val = neg ? -v : v;
+		return true;
+	};
+
+	// single character field, e.g. RMC status 'A'
+	bool nextChar( char &c ) {
+		bool ok = !isEnd(*p);
+		if( ok )
+			c = *p;
+		skip();
+		return ok;
+	};
+
+	// copy up to maxlen characters of the field, always zero terminated
+	bool nextChars( char *dst, int maxlen ) {
+		int n = 0;
+		for( const char *s = p; !isEnd(*s) && n < maxlen; s++ )
+			dst[n++] = *s;
+		dst[n] = 0;
+		skip();
+		return n > 0;
+	};
+
+private:
+	const nmea_frame_t &f;
+	const char *p;
+	int idx;
+};
+
+/*
+ * Sentence dispatch
+ *
+ * A sentence is identified by the five characters behind '$' packed into
+ * 6 bit each, e.g. nmeaTag("PFLAU"). GNSS talkers (GP, GN, GL, GA, GB) are
+ * folded to GP, so one entry serves GPRMC and GNRMC alike. Handlers live
+ * in a small open addressed table, a frame costs one hash and normally a
+ * single compare, unknown sentences (GSA, GSV ..) are counted and dropped.
+ */
+
+#define NMEA_TAG_LEN 5
+#define NMEA_DISPATCH_BITS 5     // 32 slots, keep at least twice the number of handlers
+#define NMEA_DISPATCH_SLOTS (1<<NMEA_DISPATCH_BITS)
+
+constexpr uint32_t nmeaTag( const char *t, int n=NMEA_TAG_LEN ) {
+	return n ? ((uint32_t)((t[0] - 0x20) & 0x3f) << (6*(n-1))) | nmeaTag( t+1, n-1 ) : 0;
+}
+
+typedef void (*nmea_handler_t)( const nmea_frame_t &frame );
+
+typedef struct {
+	uint32_t tag;
+	nmea_handler_t handler;
+	uint32_t count;
+} nmea_sentence_t;
+
+class NMEADispatcher {
+public:
+	NMEADispatcher() { memset( slots, 0, sizeof(slots) ); };
+
+	// frame tag with the GNSS talker folded to GP, 0 if the tag is too short
+	static uint32_t frameTag( const nmea_frame_t &frame ) {
+		char t[NMEA_TAG_LEN];
+		for( int i=0; i<NMEA_TAG_LEN; i++ ){
+			t[i] = frame.sentence[i+1];
+			if( NMEAReader::isEnd( t[i] ) )
+				return 0;
+		}
+		if( t[0] == 'G' )
+			t[1] = 'P';
+		return nmeaTag( t );
+	};
+
+	// register a handler, returns false if the table is full
+	bool add( uint32_t tag, nmea_handler_t handler ) {
+		for( int i=0; i<NMEA_DISPATCH_SLOTS; i++ ){
+			nmea_sentence_t &e = slots[(hash(tag)+i) & (NMEA_DISPATCH_SLOTS-1)];
+			if( e.tag == 0 || e.tag == tag ){
+				e.tag = tag;
+				e.handler = handler;
+				return true;
+			}
+		}
+		return false;
+	};
+
+	nmea_sentence_t *find( uint32_t tag ) {
+		for( int i=0; i<NMEA_DISPATCH_SLOTS; i++ ){
+			nmea_sentence_t &e = slots[(hash(tag)+i) & (NMEA_DISPATCH_SLOTS-1)];
+			if( e.tag == tag )
+				return &e;
+			if( e.tag == 0 )
+				break;
+		}
+		return nullptr;
+	};
+
+	// run the handler of the frame, returns false for unknown sentences
+	bool dispatch( const nmea_frame_t &frame ) {
+		uint32_t tag = frameTag( frame );
+		nmea_sentence_t *e = tag ? find( tag ) : nullptr;
+		if( !e ){
+			unknown++;
+			return false;
+		}
+		e->count++;
+		e->handler( frame );
+		return true;
+	};
+
+	inline uint32_t getUnknown() const { return unknown; };
+
+private:
+	inline static uint32_t hash( uint32_t tag ) { return (tag * 0x9E3779B1u) >> (32-NMEA_DISPATCH_BITS); };
+	nmea_sentence_t slots[NMEA_DISPATCH_SLOTS];
+	uint32_t unknown = 0;
+};
+
+/*
+PFLAA,<AlarmLevel>,<RelativeNorth>,<RelativeEast>,<RelativeVertical>,<IDType>,<ID>,<Track>,<TurnRate>,<GroundSpeed>,<ClimbRate>,<AcftType>
+ */
+inline void decodePFLAA( const nmea_frame_t &pflaa, nmea_pflaa_s &PFLAA ) {
+	NMEAReader r( pflaa );
+	r.nextInt( PFLAA.alarmLevel );
+	r.nextInt( PFLAA.relNorth );
+	r.nextInt( PFLAA.relEast );
+	r.nextInt( PFLAA.relVertical );
+	r.nextInt( PFLAA.idType );
+	r.nextHex( PFLAA.ID );
+	r.nextInt( PFLAA.track );
+	r.nextCenti( PFLAA.turnRate );
+	r.nextCenti( PFLAA.groundSpeed );
+	r.nextCenti( PFLAA.climbRate );
+	r.nextChars( PFLAA.acftType, sizeof(PFLAA.acftType)-1 );
+}
+
+/*
+$GPRMC,<Time>,<Status>,<Lat>,<N/S>,<Lon>,<E/W>,<Speed knots>,<Course>,<Date>,...
+ */
+inline void decodeGPRMC( const nmea_frame_t &gprmc, char &status, int &speedKnots, int &course ) {
+	NMEAReader r( gprmc, 2 );
+	r.nextChar( status );
+	r.seek( 7 );
+	r.nextCenti( speedKnots );
+	r.nextCenti( course );
+}
+
+#endif
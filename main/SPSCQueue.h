@@ -0,0 +1,64 @@
+/*
+ * SPSCQueue.h
+ *
+ * Bounded, wait free single producer / single consumer ring.
+ *
+ * Exactly one task may push() and exactly one other task may pop(), neither
+ * ever blocks or takes a lock. A full ring drops the new element and counts
+ * it as overflow, the producer also tracks the high water mark.
+ * MaxElements must be a power of two.
+ *
+ * Kept free of ESP-IDF includes, so it can be compiled on the host too.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+template <typename Type, size_t MaxElements>
+class SPSCQueue
+{
+	static_assert( MaxElements && !(MaxElements & (MaxElements-1)), "SPSCQueue size must be a power of two" );
+public:
+	SPSCQueue() : head(0), tail(0), overflow(0), high_water(0) {};
+
+	// producer side, returns false and counts an overflow if the ring is full
+	bool push( const Type &value ) {
+		uint32_t h = head.load( std::memory_order_relaxed );
+		uint32_t used = h - tail.load( std::memory_order_acquire );
+		if( used >= MaxElements ){
+			overflow++;
+			return false;
+		}
+		ring[h & (MaxElements-1)] = value;
+		head.store( h+1, std::memory_order_release );
+		if( used+1 > high_water )
+			high_water = used+1;
+		return true;
+	}
+
+	// consumer side, returns false if the ring is empty
+	bool pop( Type &dest ) {
+		uint32_t t = tail.load( std::memory_order_relaxed );
+		if( t == head.load( std::memory_order_acquire ) )
+			return false;
+		dest = ring[t & (MaxElements-1)];
+		tail.store( t+1, std::memory_order_release );
+		return true;
+	}
+
+	inline uint32_t getOverflow() const { return overflow; };
+	inline uint32_t getHighWater() const { return high_water; };
+
+private:
+	Type ring[MaxElements];
+	std::atomic<uint32_t> head;   // written by the producer only
+	std::atomic<uint32_t> tail;   // written by the consumer only
+	uint32_t overflow;            // producer only
+	uint32_t high_water;          // producer only
+};
+
+#endif
@@ -22,6 +22,7 @@
 #include "Serial.h"
 #include "Flarm.h"
 #include "driver/uart.h"
+#include <esp_timer.h>
 #include "DataMonitor.h"
 #include "SetupMenu.h"
 
@@ -48,34 +49,30 @@ extern xSemaphoreHandle _display;
 #define RX1_CHAR 4
 #define RX1_NL 8
 
-const uint8_t NMEA_START1 = '$';
-const uint8_t NMEA_START2 = '!';
-// NMEA stream
-const uint8_t NMEA_MIN = 0x20;
-const uint8_t NMEA_MAX = 0x7e;
-
-const uint8_t NMEA_CR = '\r';  // 13 0d
-const uint8_t NMEA_LF = '\n';  // 10 0a
-
-enum state_t Serial::state = GET_NMEA_SYNC;
-
 RingBufCPP<SString, QUEUE_SIZE> s1_tx_q;
 RingBufCPP<SString, QUEUE_SIZE> s1_rx_q;
 
 static xSemaphoreHandle qMutex=NULL;
 #define SERIAL_BUFLEN 1024
 
-char Serial::framebuffer[512];
-int  Serial::pos = 0;
-int  Serial::len = 0;
+NMEAFramer Serial::framer;
 TaskHandle_t Serial::pid = 0;
 const uart_port_t uart_num = UART_NUM_1;
 
 bool Serial::bincom_mode = false;  // we start with bincom timer inactive
-int Serial::trials=0;
+TickType_t Serial::hunt_tick = 0;
 int Serial::baudrate = 0;
-
-#define HUNTBAUDRATE_HOLDDOWN 24000   // 120 sec
+QueueHandle_t Serial::uart_queue = 0;
+uint32_t Serial::latency_hist[SERIAL_LATENCY_BINS] = { 0 };
+uint32_t Serial::rx_overrun = 0;
+char Serial::rx_ring[SERIAL_RING_LEN];
+size_t Serial::rx_head = 0;
+
+#define HUNTBAUDRATE_HOLDDOWN 120000  // ms without Flarm before autobaud hunting starts
+#define HUNTBAUDRATE_DWELL    2000    // ms per baudrate, an active Flarm sends every second at least
+#define SERIAL_IDLE_WAKE      50      // ms, housekeeping wakeup when no UART event arrives
+#define UART_BUFFER_SIZE      512
+#define UART_QUEUE_SIZE       20
 
 int Serial::pullBlock( RingBufCPP<SString, QUEUE_SIZE>& q, char *block, int size ){
         xSemaphoreTake(qMutex,portMAX_DELAY );
@@ -91,83 +88,99 @@ int Serial::pullBlock( RingBufCPP<SString, QUEUE_SIZE>& q, char *block, int size
         return total_len;
 };
 
-void Serial::process( const char *packet, int len ) {
-	// process every frame byte through state machine
+// us on the wire per character at the current baudrate, 10 bit per char
+int Serial::charTime(){
+	return baud[baudrate] ? 10000000 / baud[baudrate] : 0;
+}
+
+// Feed a block read from the RX ring through the framer and parse every complete sentence.
+// t_rx is the time the last byte of packet arrived, so the arrival of a sentence is
+// estimated by backing off the character time for every byte behind its LF.
+void Serial::process( const char *packet, int len, int64_t t_rx ) {
 	// ESP_LOGI(FNAME,"Port %d: RX len: %d bytes", port, len );
 	// ESP_LOG_BUFFER_HEXDUMP(FNAME,packet, len, ESP_LOG_INFO);
+	int char_us = charTime();
 	for (int i = 0; i < len; i++) {
-		parse_NMEA(packet[i]  );
+		if( !framer.feed( packet + i ) )
+			continue;
+		if( Flarm::getSim() )   // replayed sentences are parsed by Flarm::flarmSim()
+			continue;
+		Flarm::parseNMEA( framer.frame() );
+		int64_t arrival = t_rx - (int64_t)(len - 1 - i) * char_us;
+		addLatency( esp_timer_get_time() - arrival );
 	}
 };
 
-void Serial::parse_NMEA( char c ){
-	// ESP_LOGI(FNAME, "Port S%1d: char=%c pos=%d  state=%d", port, c, pos, state );
-	switch(state) {
-	case GET_NMEA_SYNC:
-		switch(c) {
-		case NMEA_START1:
-		case NMEA_START2:
-			pos = 0;
-			framebuffer[pos] = c;
-			pos++;
-			state = GET_NMEA_STREAM;
-			// ESP_LOGI(FNAME, "Port S%1d: NMEA Start at %d", port, pos);
-			break;
-		}
-		break;
-		case GET_NMEA_STREAM:
-			if ((c < NMEA_MIN || c > NMEA_MAX) && (c != NMEA_CR && c != NMEA_LF)) {
-				// ESP_LOGE(FNAME, "Port S%1d: Invalid NMEA character %x, restart, pos: %d, state: %d", port, (int)c, pos, state );
-				// ESP_LOG_BUFFER_HEXDUMP(FNAME, framebuffer, pos+1, ESP_LOG_INFO);
-				state = GET_NMEA_SYNC;
-				break;
-			}
-			if (pos >= sizeof(framebuffer) - 1) {
-				ESP_LOGE(FNAME, "Port S1 NMEA buffer not large enough, restart" );
-				pos = 0;
-				state = GET_NMEA_SYNC;
-			}
-			if ( c == NMEA_CR || c == NMEA_LF ) { // normal case, accordign to NMEA 183 protocol, first CR, then LF as the last char  (<CR><LF> ends the message.)
-				// but we accept also a single terminator as not relevant for the data carried        0d  0a
-				// make things clean!                                                                                                   \r  \n
-				framebuffer[pos] = NMEA_CR;       // append a CR
-				pos++;
-				framebuffer[pos] = NMEA_LF;       // append a LF
-				pos++;
-				framebuffer[pos] = 0;  // framebuffer is zero terminated
-				// pos++;
-				if( !Flarm::getSim() )
-					Flarm::parseNMEA( framebuffer, pos );
-				state = GET_NMEA_SYNC;
-				pos = 0;
-			}else{
-				framebuffer[pos] = c;
-				pos++;
-			}
-			break;
-	}
-};
+// power of two bins from 250 us up, the last bin collects everything above
+void Serial::addLatency( int64_t us ){
+	int bin = 0;
+	for( int64_t limit = 250; us >= limit && bin < SERIAL_LATENCY_BINS-1; limit <<= 1 )
+		bin++;
+	latency_hist[bin]++;
+}
 
+void Serial::dumpStats(){
+	ESP_LOGI(FNAME,"S1 RX latency <0.25ms:%u <0.5:%u <1:%u <2:%u <4:%u <8:%u <16:%u >=16:%u, overrun: %u",
+			latency_hist[0], latency_hist[1], latency_hist[2], latency_hist[3],
+			latency_hist[4], latency_hist[5], latency_hist[6], latency_hist[7], rx_overrun );
+}
 
+// Make room at the end of the RX ring. Parsed sentences are released, only the sentence
+// still being received (at most NMEA_FRAME_LEN bytes) is moved to the front, so frames
+// are always contiguous views.
+void Serial::compact(){
+	const char *p = framer.pending();
+	if( !p ){
+		rx_head = 0;
+		return;
+	}
+	rx_head = rx_ring + rx_head - p;
+	memmove( rx_ring, p, rx_head );
+	framer.rebase( rx_ring );
+}
+
+// read up to len buffered bytes straight from the driver into the RX ring, the only copy
+// between hardware and parser, then monitor and frame them in place. t_rx is the time the
+// last of the len bytes arrived.
+void Serial::receive( size_t len, int64_t t_rx ){
+	int char_us = charTime();
+	while( len > 0 ){
+		if( rx_head == SERIAL_RING_LEN )
+			compact();
+		char *dst = rx_ring + rx_head;
+		int bytes = uart_read_bytes( uart_num, dst, std::min( len, (size_t)(SERIAL_RING_LEN - rx_head) ), 0 );
+		if( bytes <= 0 )
+			break;
+		rx_head += bytes;
+		len -= bytes;
+		DM.monitorString( MON_S1, DIR_RX, dst, bytes );
+		process( dst, bytes, t_rx - (int64_t)len * char_us );
+	}
+}
 
 // Serial Handler ttyS1, S1, port 8881
+// The task sleeps on the UART driver event queue. Line feed pattern detection wakes it once
+// per complete sentence, plain data events only drain the ring when it runs half full.
 void Serial::serialHandler(void *pvParameters)
 {
-	char buf[SERIAL_BUFLEN];  // 6 messages @ 80 byte
+	char buf[SERIAL_BUFLEN];
+	uart_event_t event;
 	// Make a pause, that has avoided core dumps during enable the RX interrupt.
 	delay( 1000 );  // delay a bit serial task startup unit startup of system is through
 	ESP_LOGI(FNAME,"S1 serial handler startup");
-    unsigned int start_holddown = HUNTBAUDRATE_HOLDDOWN;  // 14000 * 5 mS = 120 sec
+	TickType_t holddown_tick = xTaskGetTickCount();
 	while( true ) {
 		// Stack supervision
 		if( uxTaskGetStackHighWaterMark( pid ) < 256 )
 			ESP_LOGW(FNAME,"Warning serial task stack low: %d bytes", uxTaskGetStackHighWaterMark( pid ) );
 		if( _selfTest ) {
 			delay( 100 );
+			xQueueReset( uart_queue );
+			uart_pattern_queue_reset( uart_num, UART_QUEUE_SIZE );
 			continue;
 		}
 		// TX part, check if there is data for Serial Interface to send
-		if( uart_wait_tx_done(uart_num, 100) ) {
+		if( uart_wait_tx_done(uart_num, 0) == ESP_OK ) {
 			int len = pullBlock( s1_tx_q, buf, 512 );
 			if( len ){
 				// ESP_LOGI(FNAME,"S1: TX len: %d bytes",  len );
@@ -177,62 +190,48 @@ void Serial::serialHandler(void *pvParameters)
 				DM.monitorString( MON_S1, DIR_TX, buf, len );
 			}
 		}
-		// --- RX handling (optimized) ---
-		uint8_t buf[SERIAL_BUFLEN];
-		uint16_t rxBytes = 0;
-
-		while (true) {
-		    size_t available = 0;
-		    // Check how many bytes are waiting in the HW buffer
-		    esp_err_t err = uart_get_buffered_data_len(uart_num, &available);
-		    if (err != ESP_OK || available == 0) break;
-
-		    // Limit read length to remaining buffer space
-		    size_t toRead = std::min(available, (size_t)(SERIAL_BUFLEN - rxBytes - 1));
-		    if (toRead == 0) break; // no room left
-
-		    // Read from UART hardware buffer
-		    int bytes = uart_read_bytes(
-		        uart_num,
-		        buf + rxBytes,
-		        toRead,
-		        20 / portTICK_PERIOD_MS   // short timeout
-		    );
-		    if (bytes <= 0) break;
-
-		    // Log the received data BEFORE increasing rxBytes
-		    DM.monitorString(MON_S1, DIR_RX, (char*)(buf + rxBytes), bytes);
-
-		    // Advance pointer
-		    rxBytes += bytes;
-
-		    // Safety: stop if buffer almost full
-		    if (rxBytes >= SERIAL_BUFLEN - 4) {
-		        ESP_LOGW(FNAME, "UART RX buffer nearly full (%d bytes)", rxBytes);
-		        break;
-		    }
-		    vTaskDelay(pdMS_TO_TICKS(5));
-		}
-
-		// Null-terminate for safety (for text/NMEA parsing)
-		buf[rxBytes] = '\0';
-
-		// Process only if something was received
-		if (rxBytes > 0) {
-		    process((char*)buf, rxBytes);
+		// RX part, block on the driver event queue
+		if( xQueueReceive( uart_queue, &event, pdMS_TO_TICKS(SERIAL_IDLE_WAKE) ) ){
+			// the last byte buffered arrived by now at the latest, bytes behind the LF
+			// arrived while the task woke up, one character time each
+			int64_t t_event = esp_timer_get_time();
+			size_t buffered = 0;
+			switch( event.type ){
+			case UART_PATTERN_DET: {
+				int pos = uart_pattern_pop_pos( uart_num );
+				uart_get_buffered_data_len( uart_num, &buffered );
+				if( pos < 0 || (size_t)pos >= buffered )   // pattern queue overrun, take what is there
+					receive( buffered, t_event );
+				else                                        // up to and including the LF
+					receive( pos + 1, t_event - (int64_t)(buffered - pos - 1) * charTime() );
+				break;
+			}
+			case UART_DATA:
+				// no line feed yet, e.g. long sentence or wrong baudrate
+				uart_get_buffered_data_len( uart_num, &buffered );
+				if( buffered >= UART_BUFFER_SIZE/2 )
+					receive( buffered, t_event );
+				break;
+			case UART_FIFO_OVF:
+			case UART_BUFFER_FULL:
+				rx_overrun++;
+				ESP_LOGW(FNAME,"S1 RX overrun, flush (%d)", event.type );
+				uart_flush_input( uart_num );
+				xQueueReset( uart_queue );
+				uart_pattern_queue_reset( uart_num, UART_QUEUE_SIZE );
+				break;
+			default:
+				break;
+			}
 		}
 		if( Flarm::connected() ){ // normal operation
 			if( serial1_speed.get() != baudrate )    // save when new baudrate has have been detected
 				saveBaudrate();
-			start_holddown = HUNTBAUDRATE_HOLDDOWN;  // rewind autobaud hunting holddown timer
+			holddown_tick = xTaskGetTickCount();  // rewind autobaud hunting holddown timer
 		}
-		// ESP_LOGI(FNAME,"FC: %d, HD: %d", Flarm::connected(), start_holddown );
-		if( !Flarm::connected() && !start_holddown ){
+		else if( (xTaskGetTickCount() - holddown_tick) > pdMS_TO_TICKS(HUNTBAUDRATE_HOLDDOWN) ){
 			huntBaudrate();
 		}
-		if( start_holddown > 0 )
-			start_holddown--;
-		vTaskDelay(pdMS_TO_TICKS(5));
 	} // end while( true )
 }
 
@@ -295,9 +294,8 @@ void Serial::saveBaudrate(){
 
 
 void Serial::huntBaudrate(){
-	trials++;
-	if( trials>400 ) { // An active Flarm sends every second at least
-		trials = 0;
+	if( (xTaskGetTickCount() - hunt_tick) > pdMS_TO_TICKS(HUNTBAUDRATE_DWELL) ) {
+		hunt_tick = xTaskGetTickCount();
 		baudrate++;
 		if( baudrate > 6 ){
 			baudrate=1;  // 4800
@@ -376,11 +374,12 @@ void Serial::begin(){
 	ESP_LOGI(FNAME,"Serial Interface ttyS1 enabled with serial speed: %d baud: %d tx_inv: %d rx_inv: %d",  serial1_speed.get(), baud[serial1_speed.get()], serial1_tx_inverted.get(), serial1_rx_inverted.get() );
 
 
-	const int uart_buffer_size = 512;
-	QueueHandle_t uart_queue;
 	// Install UART driver using an event queue here
 	// esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags)
-	ESP_ERROR_CHECK(uart_driver_install(uart_num, uart_buffer_size, uart_buffer_size, 10, &uart_queue, 0));
+	ESP_ERROR_CHECK(uart_driver_install(uart_num, UART_BUFFER_SIZE, UART_BUFFER_SIZE, UART_QUEUE_SIZE, &uart_queue, 0));
+	// raise UART_PATTERN_DET on every line feed, the end of each NMEA sentence
+	ESP_ERROR_CHECK(uart_enable_pattern_det_baud_intr(uart_num, '\n', 1, 9, 0, 0));
+	ESP_ERROR_CHECK(uart_pattern_queue_reset(uart_num, UART_QUEUE_SIZE));
     taskStart();
 
 }
@@ -17,6 +17,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "HardwareSerial.h"
+#include "NMEA.h"
 
 #define SERIAL_STRLEN SSTRLEN
 
@@ -31,16 +32,11 @@
 #define TX2_REQ 128
 
 #define QUEUE_SIZE 8
+#define SERIAL_LATENCY_BINS 8
+#define SERIAL_RING_LEN (2*NMEA_FRAME_LEN)   // RX ring, frames are parsed in place
 
 const int baud[] = { 0, 4800, 9600, 19200, 38400, 57600, 115200 };
 
-// state machine definition
-enum state_t {
-	GET_NMEA_SYNC,
-	GET_NMEA_STREAM
-};
-
-
 class Serial {
 public:
 	Serial(){
@@ -51,22 +47,30 @@ public:
 	static void serialHandler(void *pvParameters);
 	static bool selfTest();
 	static int  pullBlock( RingBufCPP<SString, QUEUE_SIZE>& q, char *block, int size );
-	static void process( const char *packet, int len );
-	static void parse_NMEA( char c );
+	static void process( const char *packet, int len, int64_t t_rx );
 	static void huntBaudrate();
 	static void saveBaudrate();
+	static uint32_t getBadChecksum() { return framer.getBadChecksum(); };
+	static uint32_t getOverflow() { return framer.getOverflow(); };
+	static void dumpStats();
 
 private:
-	static enum state_t state;
 	static bool _selfTest;
 	static EventGroupHandle_t rxTxNotifier;
 	// Stop routing of TX/RX data. That is used in case of Flarm binary download.
 	static bool bincom_mode;
-	static char framebuffer[512];
-	static int  pos;
-	static int  len;
+	static void receive( size_t len, int64_t t_rx );
+	static int charTime();
+	static void compact();
+	static void addLatency( int64_t us );
+	static NMEAFramer framer;
+	static QueueHandle_t uart_queue;
+	static uint32_t latency_hist[SERIAL_LATENCY_BINS];  // LF on the wire to sentence parsed
+	static uint32_t rx_overrun;
+	static char rx_ring[SERIAL_RING_LEN];
+	static size_t rx_head;    // next free byte of rx_ring
 	static TaskHandle_t pid;
-	static int trials;
+	static TickType_t hunt_tick;
 	static int baudrate;
 };
 
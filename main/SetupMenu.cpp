@@ -359,6 +359,14 @@ void SetupMenu::options_menu_create_settings( MenuEntry *top ){
 	top->addEntry( log );
 	log->setHelp("Select distance either linear or logarithmic what zooms far distant targets on the screen", hpos );
 
+	SetupMenuSelect * rate = new SetupMenuSelect( "Display Rate", RST_NONE, 0, true, &display_rate );
+	rate->addEntry( "2 Hz");
+	rate->addEntry( "4 Hz");
+	rate->addEntry( "5 Hz");
+	rate->addEntry( "10 Hz");
+	top->addEntry( rate );
+	rate->setHelp("Targets are redrawn at this rate, moved ahead from their last FLARM position in between", hpos );
+
 	SetupMenuSelect * nmove = new SetupMenuSelect( "Not moving planes", RST_NONE, 0, true, &display_non_moving_target );
 	nmove->addEntry( "Hide");
 	nmove->addEntry( "Show");
@@ -56,6 +56,7 @@ SetupNG<int>  			display_orientation("DISPLAY_ORIENT" , DISPLAY_NORMAL );
 SetupNG<int>  			display_mode("DISPLAY_MODE" , DISPLAY_MULTI );
 SetupNG<int>  			display_non_moving_target("NON_MOVE" , NON_MOVE_HIDE );
 SetupNG<int>  			notify_near( "NOTFNEAR", BUZZ_2KM );
+SetupNG<int>  			display_rate( "DISP_RATE", RATE_4HZ );
 SetupNG<int>  			rs232_polarity( "RS232POL", RS232_INVERTED );
 SetupNG<int>            team_id("TEAMID", 0 );
 
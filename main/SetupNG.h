@@ -57,6 +57,7 @@ typedef enum e_vario_unit { VARIO_UNIT_MS, VARIO_UNIT_FPM, VARIO_UNIT_KNOTS } e_
 typedef enum e_data_monitor { MON_OFF, MON_S1 }  e_data_monitor_t;
 typedef enum e_non_move { NON_MOVE_HIDE, NON_MOVE_DISPLAY } e_non_move_t;
 typedef enum e_buzz_notify { BUZZ_OFF, BUZZ_1KM, BUZZ_2KM } e_buzz_notify_t;
+typedef enum e_display_rate { RATE_2HZ, RATE_4HZ, RATE_5HZ, RATE_10HZ } e_display_rate_t;
 
 void change_bal();
 
@@ -339,6 +340,7 @@ extern SetupNG<int>  		display_orientation;
 extern SetupNG<int>  		display_mode;
 extern SetupNG<int>  		display_non_moving_target;
 extern SetupNG<int>  		notify_near;
+extern SetupNG<int>  		display_rate;
 extern SetupNG<int>  		rs232_polarity;
 extern SetupNG<int>         team_id;
 
@@ -7,11 +7,13 @@
 
 #include "Target.h"
 #include <cmath>
+#include <esp_timer.h>
 #include <AdaptUGC.h>
 #include "vector.h"
-#include "flarmnetdata.h"
+#include "Flarmnet.h"
 #include "flarmview.h"
 #include "TargetManager.h"
+#include "Compositor.h"
 
 extern AdaptUGC *egl;
 #define TARGET_SIZE_MIN 10
@@ -23,6 +25,14 @@ unsigned int Target::old_alt = 100000;
 unsigned int Target::old_id = 0;
 int Target::old_var = -10000;
 int Target::blink = 0;
+bangle_t Target::view_course = 0;
+int Target::own_vn = 0;
+int Target::own_ve = 0;
+uint32_t Target::frame_ms = 0;
+int Target::view_zoom = 0;
+bool Target::view_log = false;
+uint8_t Target::frame_dirty = 0;
+uint32_t Target::recalcs = 0;
 extern xSemaphoreHandle _display;
 char Target::cur_dist[32] = "\0";
 char Target::cur_alt[32] = "\0";
@@ -37,30 +47,29 @@ inline T clamp(T val, T minVal, T maxVal) {
     return val;
 }
 
-Target::Target() {
+Target::Target() : slot(0) {
 
 }
 
-Target::Target(nmea_pflaa_s a_pflaa) {
+// the hot state of the target is set up in TargetStore at a_slot
+Target::Target(nmea_pflaa_s a_pflaa, int a_slot, uint32_t time) {
+    slot = a_slot;
     pflaa = a_pflaa;
-    old_x0 = old_y0 = old_x1 = old_y1 = old_x2 = old_y2 = -1000;
-    old_track = 0; old_climb = -1000; old_x = old_y = 0;
-    old_size = old_sidelen = old_cirsize = old_cirsizeteam = -1;
-    tek_climb = 0.0; last_groundspeed = pflaa.groundSpeed;
-    tick = 0; last_pflaa_time = -1; _buzzedHoldDown = 0;
-    dist = prox = 10000.0; recalc();
-    reg = comp = nullptr; age = 0; is_nearest = false; alarm = false; alarm_timer = 0;
-    _isPriority = false;
-    is_best = false;
-    is_nearest = false;
-    firstDraw = true;
-
-    for (int i=0;i<sizeof(flarmnet_db)/sizeof(flarmnet_db[0]);i++){
-        if (pflaa.ID == flarmnet_db[i].id){
-            reg = (char*)flarmnet_db[i].reg;
-            comp = (char*)flarmnet_db[i].cn;
-        }
-    }
+    TargetStore::id[slot] = pflaa.ID;
+    TargetStore::setClimb(slot, pflaa.climbRate);
+    TargetStore::flags[slot] = 0;
+    TargetStore::seen[slot] = time;
+    old_track = 0;
+    tek_climb = 0; last_groundspeed = pflaa.groundSpeed/NMEA_CENTI;
+    buzzed = false; buzz_ms = alarm_ms = 0;
+    dirty = DIRTY_ALL; tri_side = -1;
+    rel_n = pflaa.relNorth; rel_e = pflaa.relEast; rel_v = pflaa.relVertical;
+    track = bangleFromCentiDeg(pflaa.track*100);
+    predict();
+    recalc();
+    reg[0] = comp[0] = '\0';
+
+    Flarmnet::find(pflaa.ID, reg, comp);   // copied, the partition may be rewritten meanwhile
 
     switch (notify_near.get()) {
         case BUZZ_OFF: dist_buzz=-1.0; break;
@@ -70,37 +79,34 @@ Target::Target(nmea_pflaa_s a_pflaa) {
     }
 }
 
+// --- drawText ---
+// text of the radar screen, in the font origin the screen is drawn with
+void Target::drawText(int x, int y, uint8_t *font, ucg_color_t color, const char *s){
+    Compositor::text(x, y, AdaptUGC::getFont(font), egl->getFontOrigin(), egl->toColor(color), s);
+}
+
 // --- Drawing small info ---
 void Target::drawDist(uint8_t r, uint8_t g, uint8_t b){
-    egl->setColor(r,g,b);
     egl->setFont(ucg_font_fub20_hf);
     int w = egl->getStrWidth(cur_dist);
-    egl->setPrintPos((DISPLAY_W-5)-w,30);
-    egl->printf("%s",cur_dist);
+    drawText((DISPLAY_W-5)-w,30,ucg_font_fub20_hf,{r,g,b},cur_dist);
 }
 
 void Target::drawID(uint8_t r, uint8_t g, uint8_t b){
-    egl->setColor(r,g,b);
-    egl->setFont(ucg_font_fub20_hf);
+    uint8_t *font = ucg_font_fub20_hf;
+    egl->setFont(font);
     int w = egl->getStrWidth(cur_id);
-    if(w>150){ egl->setFont(ucg_font_fub17_hf); w=egl->getStrWidth(cur_id); }
-    if(w>150){ egl->setFont(ucg_font_fub14_hf); w=egl->getStrWidth(cur_id); }
-    egl->setPrintPos((DISPLAY_W-5)-w,DISPLAY_H-7);
-    egl->printf("%s",cur_id);
+    if(w>150){ font=ucg_font_fub17_hf; egl->setFont(font); w=egl->getStrWidth(cur_id); }
+    if(w>150){ font=ucg_font_fub14_hf; egl->setFont(font); w=egl->getStrWidth(cur_id); }
+    drawText((DISPLAY_W-5)-w,DISPLAY_H-7,font,{r,g,b},cur_id);
 }
 
 void Target::drawAlt(uint8_t r,uint8_t g,uint8_t b){
-    egl->setColor(r,g,b);
-    egl->setFont(ucg_font_fub20_hf);
-    egl->setPrintPos(5,DISPLAY_H-7);
-    egl->printf("%s",cur_alt);
+    drawText(5,DISPLAY_H-7,ucg_font_fub20_hf,{r,g,b},cur_alt);
 }
 
 void Target::drawVar(uint8_t r,uint8_t g,uint8_t b){
-    egl->setColor(r,g,b);
-    egl->setFont(ucg_font_fub20_hf);
-    egl->setPrintPos(5,30);
-    egl->printf("%s",cur_var);
+    drawText(5,30,ucg_font_fub20_hf,{r,g,b},cur_var);
 }
 
 void Target::redrawInfo(){
@@ -108,143 +114,116 @@ void Target::redrawInfo(){
 }
 
 
-void Target::drawInfo(bool erase) {
+// the fields are formatted when their value changed, but added to the scene
+// every frame: the compositor sends only what differs from the last frame,
+// and a field not added any more is erased
+void Target::drawInfo() {
 	if(!egl) return;
 	char buf[32] = {0};
 	if (pflaa.ID == 0) return;
+	float dist = TargetStore::dist[slot];
 	DisplayLock lock(_display);
 
 	// --- Distance ---
-	if ((old_dist != (int)(dist * 100)) || erase) {
-		if (strlen(cur_dist)) drawDist(COLOR_BLACK);
-		if (!erase) {
-			snprintf(cur_dist, sizeof( cur_dist ), "%.2f", Units::Distance(dist));
-			drawDist(COLOR_WHITE);
-			old_dist = (int)(dist * 100);
-		} else {
-			cur_dist[0] = '\0';
-		}
+	if (old_dist != (int)(dist * 100)) {
+		snprintf(cur_dist, sizeof( cur_dist ), "%.2f", Units::Distance(dist));
+		old_dist = (int)(dist * 100);
 	}
+	drawDist(COLOR_WHITE);
 
 	// --- ID ---
-	if ((old_id != pflaa.ID) || erase) {
-		if (strlen(cur_id)) drawID(COLOR_BLACK);
-		if (!erase) {
-			if (reg) {
-				if (comp) sprintf(cur_id, "%s %s", reg, comp);
-				else      sprintf(cur_id, "%s", reg);
-			} else {
-				snprintf(cur_id, sizeof( cur_id ), "%06X", pflaa.ID);
-			}
-			drawID(COLOR_WHITE);
-			old_id = pflaa.ID;
+	if (old_id != pflaa.ID) {
+		if (reg[0]) {
+			if (comp[0]) sprintf(cur_id, "%s %s", reg, comp);
+			else      sprintf(cur_id, "%s", reg);
 		} else {
-			cur_id[0] = '\0';
+			snprintf(cur_id, sizeof( cur_id ), "%06X", pflaa.ID);
 		}
+		old_id = pflaa.ID;
 	}
+	drawID(COLOR_WHITE);
 
 	// --- Altitude ---
-	if ((old_alt != pflaa.relVertical) || erase) {
-		if (strlen(cur_alt)) drawAlt(COLOR_BLACK);
-		if (!erase) {
-			int alt = (int)(Units::Altitude(pflaa.relVertical + 0.5));
-			snprintf(cur_alt, sizeof( cur_alt ), "%s%d", (pflaa.relVertical > 0) ? "+" : "", alt);
-			drawAlt(COLOR_WHITE);
-			old_alt = pflaa.relVertical;
-		} else {
-			cur_alt[0] = '\0';
-		}
+	if (old_alt != pflaa.relVertical) {
+		int alt = (int)(Units::Altitude(pflaa.relVertical + 0.5));
+		snprintf(cur_alt, sizeof( cur_alt ), "%s%d", (pflaa.relVertical > 0) ? "+" : "", alt);
+		old_alt = pflaa.relVertical;
 	}
+	drawAlt(COLOR_WHITE);
 
 	// --- Vario ---
-	if ((old_var != (int)(pflaa.climbRate * 10)) || erase) {
-		if (strlen(cur_var)) drawVar(COLOR_BLACK);
-		if (!erase) {
-			float climb = Units::Vario((float)pflaa.climbRate);
-			snprintf(cur_var, sizeof( cur_var ), "%+.1f", climb);
-			drawVar(COLOR_WHITE);
-			old_var = (int)(pflaa.climbRate * 10);
-		} else {
-			cur_var[0] = '\0';
-		}
+	if (old_var != pflaa.climbRate/10) {
+		float climb = Units::Vario(pflaa.climbRate/(float)NMEA_CENTI);
+		snprintf(cur_var, sizeof( cur_var ), "%+.1f", climb);
+		old_var = pflaa.climbRate/10;
 	}
+	drawVar(COLOR_WHITE);
 
 	// --- Units display ---
-	if (erase) egl->setColor(COLOR_BLACK);
-	else       egl->setColor(COLOR_BLUE);
-
 	egl->setFont(ucg_font_fub14_hf);
 
 	int w = egl->getStrWidth("ID");
-	egl->setPrintPos(DISPLAY_W - 5 - w, DISPLAY_H - 37);
-	egl->printf("ID");
+	drawText(DISPLAY_W - 5 - w, DISPLAY_H - 37, ucg_font_fub14_hf, {COLOR_BLUE}, "ID");
 
 	sprintf(buf, "Dis %s", Units::DistanceUnit());
 	w = egl->getStrWidth(buf);
-	egl->setPrintPos(DISPLAY_W - 5 - w, 50);
-	egl->printf("%s", buf);
+	drawText(DISPLAY_W - 5 - w, 50, ucg_font_fub14_hf, {COLOR_BLUE}, buf);
 
-	egl->setPrintPos(5, 50);
-	egl->printf("Var %s", Units::VarioUnit());
+	sprintf(buf, "Var %s", Units::VarioUnit());
+	drawText(5, 50, ucg_font_fub14_hf, {COLOR_BLUE}, buf);
 
-	egl->setPrintPos(5, DISPLAY_H - 37);
-	egl->printf("Alt %s", Units::AltitudeUnit());
+	sprintf(buf, "Alt %s", Units::AltitudeUnit());
+	drawText(5, DISPLAY_H - 37, ucg_font_fub14_hf, {COLOR_BLUE}, buf);
 }
 
 
 
 // --- drawClimb ---
-void Target::drawClimb(int x,int y,int size,int climb){
+void Target::drawClimb(int x,int y,int size,int climb,ucg_color_t color){
     if(climb>1){
-        egl->setPrintPos(x-4,y-size);
-        egl->setFont(ucg_font_ncenR14_hr);
-        egl->printf("%d",climb);
+        char buf[12];
+        snprintf(buf,sizeof(buf),"%d",climb);
+        drawText(x-4,y-size,ucg_font_ncenR14_hr,color,buf);
     }
 }
 
 // --- drawFlarmTarget ---
-void Target::drawFlarmTarget(int ax,int ay,int bearing,int sideLength,bool erase,bool closest,ucg_color_t color,bool follow){
-    float radians=D2R(bearing-90.0f);
-    float axt=ax-sideLength/4.0f*sin(D2R((float)bearing));
-    float ayt=ay+sideLength/4.0f*cos(D2R((float)bearing));
-
-    int x0=rint(axt + sideLength*cos(radians));
-    int y0=rint(ayt + sideLength*sin(radians));
-    int x1=rint(axt + sideLength/2.0f*cos(radians+2*M_PI/3));
-    int y1=rint(ayt + sideLength/2.0f*sin(radians+2*M_PI/3));
-    int x2=rint(axt + sideLength/2.0f*cos(radians-2*M_PI/3));
-    int y2=rint(ayt + sideLength/2.0f*sin(radians-2*M_PI/3));
-    int climb=int(tek_climb+0.5f);
-
-    if(erase || old_closest!=closest || old_climb!=climb || old_sidelen!=sideLength ||
-       old_x0!=x0 || old_y0!=y0 || old_x1!=x1 || old_y1!=y1 || old_x2!=x2 || old_y2!=y2 || firstDraw) {
-    	DisplayLock lock(_display);
-    	firstDraw = false;
-        egl->setColor(COLOR_BLACK);
-        if(old_x0>0) egl->drawTriangle(old_x0,old_y0,old_x1,old_y1,old_x2,old_y2);
-        if(old_closest && old_cirsize>0){ egl->drawCircle(old_ax,old_ay,old_cirsize); }
-        if(old_cirsizeteam>0){ egl->drawCircle(old_ax,old_ay,old_cirsizeteam); egl->drawCircle(old_ax,old_ay,old_cirsizeteam+1); }
-        if(old_climb!=-1000) drawClimb(old_x,old_y,old_size,old_climb);
-        old_x0=old_x1=old_x2=-1; old_sidelen=old_climb=old_cirsize=old_cirsizeteam=-1;
+// triangle pointing to bearing, its center a quarter side length behind ax, ay.
+// Called with the position and heading from recalc() only, so the corners are
+// rebuilt when recalc() ran or the size changed. Adds the symbol to the scene
+// of this frame, erase leaves it out, see Compositor.
+void Target::drawFlarmTarget(int ax,int ay,bangle_t bearing,int sideLength,bool erase,bool closest,ucg_color_t color,bool follow){
+    if((dirty & DIRTY_GEOM) || sideLength!=tri_side){
+        bangle_t radians=bearing-BANGLE_90;
+        int axt=ax*FIX_ONE-sideLength*fixSin(bearing)/4;   // Q15
+        int ayt=ay*FIX_ONE+sideLength*fixCos(bearing)/4;
+        tri[0]=(axt + sideLength*fixCos(radians) + FIX_ONE/2)>>15;
+        tri[1]=(ayt + sideLength*fixSin(radians) + FIX_ONE/2)>>15;
+        tri[2]=(axt + sideLength*fixCos(radians+BANGLE_120)/2 + FIX_ONE/2)>>15;
+        tri[3]=(ayt + sideLength*fixSin(radians+BANGLE_120)/2 + FIX_ONE/2)>>15;
+        tri[4]=(axt + sideLength*fixCos(radians-BANGLE_120)/2 + FIX_ONE/2)>>15;
+        tri[5]=(ayt + sideLength*fixSin(radians-BANGLE_120)/2 + FIX_ONE/2)>>15;
+        tri_side=sideLength;
+        dirty&=~DIRTY_GEOM;
     }
+    int x0=tri[0], y0=tri[1];
+    int climb=(tek_climb+NMEA_CENTI/2)/NMEA_CENTI;
 
-    if(x0<=0||x0>=DISPLAY_W||y0<=0||y0>=DISPLAY_H) return;
+    if(erase || x0<=0||x0>=DISPLAY_W||y0<=0||y0>=DISPLAY_H) return;
 
-    if(!erase){
-    	DisplayLock lock(_display);
-        egl->setColor(color.color[0],color.color[1],color.color[2]);
-        egl->drawTriangle(x0,y0,x1,y1,x2,y2);
-        if(is_best){ drawClimb(ax,ay,sideLength,climb); old_climb=climb; old_size=sideLength; old_x=ax; old_y=ay; }
-        if(closest){ int len=rint(sideLength*0.75f); egl->drawCircle(ax,ay,len); old_cirsize=len; }
-        if(follow){ int len=rint(sideLength*0.75f+2.0f); egl->setColor(COLOR_RED); egl->drawCircle(ax,ay,len); egl->drawCircle(ax,ay,len+1); old_cirsizeteam=len; }
-        old_x0=x0; old_y0=y0; old_x1=x1; old_y1=y1; old_x2=x2; old_y2=y2; old_ax=ax; old_ay=ay; old_closest=closest;
-    }
+    color_t c=egl->toColor(color);
+    Compositor::triangle(x0,y0,tri[2],tri[3],tri[4],tri[5],c);
+    if(isBestClimber()) drawClimb(ax,ay,sideLength,climb,color);
+    if(closest){ int len=(sideLength*3+2)/4; Compositor::circle(ax,ay,len,c); }
+    if(follow){ int len=(sideLength*3+2)/4+2; color_t red=egl->toColor(COLOR_RED); Compositor::circle(ax,ay,len,red); Compositor::circle(ax,ay,len+1,red); }
 }
 
 // --- draw ---
 void Target::draw(bool erase, bool follow){
 	if(!egl) return;
     checkAlarm();
+    float dist = TargetStore::dist[slot];
+    int age = getAge();
     int size = clamp(10 + int(10.0/std::max(dist, 0.001f)), TARGET_SIZE_MIN, TARGET_SIZE_MAX);
     uint8_t brightness = uint8_t(255 - 255.0 * std::min(1.0, age/(double)AGEOUT));
     ucg_color_t color;
@@ -252,56 +231,126 @@ void Target::draw(bool erase, bool follow){
         if(haveAlarm()) color = (blink++%2)? ucg_color_t{COLOR_WHITE}: ucg_color_t{COLOR_RED};
         else color = {brightness,brightness,brightness};
     } else color = {0, brightness, 0};
-    drawFlarmTarget(x,y,rel_target_heading,size,erase,is_nearest,color,follow);
+    drawFlarmTarget(TargetStore::x[slot],TargetStore::y[slot],rel_target_heading,size,erase,isNearest(),color,follow);
 }
 
 // --- update ---
-void Target::update(nmea_pflaa_s a_pflaa){
-    pflaa=a_pflaa; recalc(); if(last_pflaa_time>0) tekCalc();
-    last_groundspeed=pflaa.groundSpeed;
-    last_pflaa_time=tick;
-    age=0;
+void Target::update(nmea_pflaa_s a_pflaa, uint32_t time){
+    pflaa=a_pflaa; dirty|=DIRTY_DATA; tekCalc(time-TargetStore::seen[slot]);
+    last_groundspeed=pflaa.groundSpeed/NMEA_CENTI;
+    TargetStore::setClimb(slot, pflaa.climbRate);
+    TargetStore::seen[slot]=time;   // also re-anchors the dead reckoning
 }
 
-// --- ageTarget ---
-void Target::ageTarget(){
-    raw_tick++; if(!(raw_tick%4)) tick++;
-    if(age<1000) age++;
-    if(_buzzedHoldDown) _buzzedHoldDown--;
-    recalc();
+// --- extrapolate ---
+void Target::extrapolate(){
+    predict();
+    dirty|=frame_dirty;
+    if(dirty & DIRTY_ALL) recalc();
+}
+
+// --- beginFrame ---
+void Target::beginFrame(){
+    frame_ms = esp_timer_get_time()/1000;
+    bangle_t course = bangleFromCentiDeg(Flarm::getGndCourseCenti());
+    int speed = (Flarm::getGndSpeedCentiKnots()*1852 + 1800)/3600;   // cm/s
+    own_vn = fixMul(speed, fixCos(course));
+    own_ve = fixMul(speed, fixSin(course));
+    int z = zoom*256;
+    bool l = log_scale.get();
+    frame_dirty = (course!=view_course ? DIRTY_COURSE : 0) | (z!=view_zoom ? DIRTY_ZOOM : 0) | (l!=view_log ? DIRTY_SCALE : 0);
+    view_course = course;
+    view_zoom = z;
+    view_log = l;
+}
+
+#define REL_MAX 30000   // m, the squares of all three components stay within 32 bit
+
+// --- predict ---
+// relative position at frame_ms from the last PFLAA, the target flying along
+// its track, turning at turnRate, climbing at climbRate, minus the own motion
+// from GPRMC. The chord of a turn is taken along the mean track. Only marks
+// the data dirty if the position moved by a meter or the track changed.
+void Target::predict(){
+    int dt = clamp((int)(frame_ms - TargetStore::seen[slot]), 0, DR_MAX_MS);   // ms
+    int turn = (pflaa.turnRate*dt/1000) % 36000;   // 1/100 deg
+    bangle_t mid = bangleFromCentiDeg((pflaa.track*100 + turn/2) % 36000);
+    int vn = fixMul(pflaa.groundSpeed, fixCos(mid)) - own_vn;   // cm/s
+    int ve = fixMul(pflaa.groundSpeed, fixSin(mid)) - own_ve;
+    int n = pflaa.relNorth + vn*dt/100000;
+    int e = pflaa.relEast + ve*dt/100000;
+    int v = pflaa.relVertical + pflaa.climbRate*dt/100000;
+    bangle_t t = bangleFromCentiDeg((pflaa.track*100 + turn) % 36000);
+    if (n!=rel_n || e!=rel_e || v!=rel_v || t!=track) {
+        rel_n = n; rel_e = e; rel_v = v; track = t;
+        dirty |= DIRTY_DATA;
+    }
+    // motion of this frame for TargetStore::computeCPA()
+    TargetStore::rn[slot]=clamp(n, -REL_MAX, REL_MAX);
+    TargetStore::re[slot]=clamp(e, -REL_MAX, REL_MAX);
+    TargetStore::rv[slot]=clamp(v, -REL_MAX, REL_MAX);
+    TargetStore::vn[slot]=clamp(vn/10, -CPA_VMAX, CPA_VMAX);
+    TargetStore::ve[slot]=clamp(ve/10, -CPA_VMAX, CPA_VMAX);
 }
 
 // --- recalc ---
+// integer only, see FixMath.h, and only the parts whose inputs are dirty
+#define LN_1000 452707  // ln(1000) Q16, ln(2+km) = ln(2000+m) - ln(1000)
+
+static inline int logPix(int m){
+    return (SCALE * (fixLn(2000 + m) - LN_1000) + 0x8000) >> 16;
+}
+
 void Target::recalc(){
-    rel_target_heading=rint(Vector::angleDiffDeg((float)pflaa.track,Flarm::getGndCourse()));
-    rel_target_dir=Vector::angleDiffDeg(R2D(atan2(pflaa.relEast,pflaa.relNorth)),Flarm::getGndCourse());
-    dist=sqrt(pflaa.relNorth*pflaa.relNorth+pflaa.relEast*pflaa.relEast)/1000.0f;
-    float relV = pflaa.relVertical/1000.0f;
-    prox = sqrt(relV*relV + dist*dist);
-    float pix = inch2dot4 ? std::max(20.0f, zoom*(log_scale.get()?log(2+dist):dist)*SCALE)
-                          : std::max(30.0f, log(2+prox)*SCALE);
-    x=DISPLAY_W/2 + pix*sin(D2R(rel_target_dir));
-    y=DISPLAY_H/2 - pix*cos(D2R(rel_target_dir));
+    recalcs++;
+    if (dirty & DIRTY_DATA) {
+        int n = clamp(rel_n, -REL_MAX, REL_MAX);
+        int e = clamp(rel_e, -REL_MAX, REL_MAX);
+        int v = clamp(rel_v, -REL_MAX, REL_MAX);
+        bearing = fixAtan2(e, n);
+        dist_m = fixSqrt(n*n + e*e);
+        prox_m = fixSqrt((uint32_t)dist_m*dist_m + (uint32_t)(v*v));
+        TargetStore::dist[slot]=dist_m*0.001f;
+        TargetStore::prox[slot]=prox_m*0.001f;
+    }
+    if (dirty & (DIRTY_DATA | DIRTY_ZOOM | DIRTY_SCALE)) {
+        if (inch2dot4)   // zoom before the division, linear steps of 1/256 px, 32 bit unsigned for 30 km at zoom 4.6
+            pix = std::max(20, view_log ? (view_zoom * logPix(dist_m)) >> 8
+                                        : (int)(((uint32_t)dist_m * view_zoom * SCALE / 1000) >> 8));
+        else
+            pix = std::max(30, logPix(prox_m));
+    }
+    rel_target_heading = track - view_course;
+    rel_target_dir = bearing - view_course;
+    TargetStore::x[slot]=DISPLAY_W/2 + fixMul(pix, fixSin(rel_target_dir));
+    TargetStore::y[slot]=DISPLAY_H/2 - fixMul(pix, fixCos(rel_target_dir));
+    dirty = DIRTY_GEOM;
 }
 
 // --- tekCalc ---
-void Target::tekCalc(){
+// total energy compensation in 1/100 m/s: v*dv/(g*dt), g as 981/100 m/s^2, dt in ms
+void Target::tekCalc(uint32_t dt){
     tek_climb = pflaa.climbRate;
-    int dt = tick - last_pflaa_time;
-    int v = pflaa.groundSpeed;
+    int v = pflaa.groundSpeed/NMEA_CENTI;
     int dv = v-last_groundspeed;
-    if(dv<5 && last_groundspeed>0 && pflaa.groundSpeed>12 && dt>=1 && dt<10){
-        if(dt!=0) tek_climb += ((v*dv)/(9.81f*dt)-tek_climb)*0.2f;
+    if(dv<5 && last_groundspeed>0 && v>12 && dt>=1000 && dt<10000){
+        int te = (v*dv*NMEA_CENTI*NMEA_CENTI)/981*1000/(int)dt;
+        tek_climb += (te-tek_climb)/5;
     }
 }
 
 // --- checkClose ---
 void Target::checkClose(){
     if(dist_buzz<0) return;
-    if(dist<dist_buzz && _buzzedHoldDown==0){
+    float dist = TargetStore::dist[slot];
+    // closer than dist_buzz, or going to be within CPA_BUZZ_TIME
+    int t = TargetStore::tcpa[slot];
+    bool close = dist<dist_buzz || (t && t<=CPA_BUZZ_TIME && TargetStore::cpa[slot]<dist_buzz*1000);
+    if(buzzed && frame_ms-buzz_ms>=BUZZ_HOLDDOWN) buzzed=false;
+    if(close && !buzzed){
         Buzzer::play2(BUZZ_DH,200,audio_volume.get(),BUZZ_E,200,audio_volume.get());
-        _buzzedHoldDown=12000;
-    } else if(dist>(dist_buzz*2.0)) _buzzedHoldDown=0;
+        buzzed=true; buzz_ms=frame_ms;
+    } else if(!close && dist>(dist_buzz*2.0)) buzzed=false;
 }
 
 // --- checkAlarm ---
@@ -309,15 +358,14 @@ void Target::checkAlarm(){
     if(pflaa.alarmLevel==1) { Buzzer::play2(BUZZ_DH,150,audio_volume.get(),BUZZ_DH,150,0,6); setAlarm(); }
     else if(pflaa.alarmLevel==2) { Buzzer::play2(BUZZ_E,100,audio_volume.get(),BUZZ_E,100,0,10); setAlarm(); }
     else if(pflaa.alarmLevel==3) { Buzzer::play2(BUZZ_F,70,audio_volume.get(),BUZZ_F,70,0,15); setAlarm(); }
-    if(alarm_timer==0) alarm=false;
-    if(alarm_timer) alarm_timer--;
+    else if(frame_ms-alarm_ms>=ALARM_HOLD) TargetStore::setFlag(slot,TGT_ALARM,false);
 }
 
 // --- dumpInfo ---
 void Target::dumpInfo(){
-    // ESP_LOGI(FNAME,"Target ID: %06X | Age: %d | Dist: %.2f km | Alt: %d m | Climb: %.1f m/s | Track: %d",
-    //         pflaa.ID, age, dist, pflaa.relVertical, pflaa.climbRate, pflaa.track);
-    // if(reg || comp) ESP_LOGI(FNAME,"  Reg: %s | Comp: %s", reg?reg:"-", comp?comp:"-");
+    // ESP_LOGI(FNAME,"Target ID: %06X | Age: %d | Dist: %.2f km | Alt: %d m | Climb: %d cm/s | Track: %d",
+    //         pflaa.ID, getAge(), TargetStore::dist[slot], pflaa.relVertical, pflaa.climbRate, pflaa.track);
+    // if(reg[0] || comp[0]) ESP_LOGI(FNAME,"  Reg: %s | Comp: %s", reg, comp);
 }
 
 // --- destructor ---
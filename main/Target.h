@@ -5,9 +5,13 @@
  *      Author: esp32s2
  */
 
+#include <algorithm>
 #include "Flarm.h"
 #include "Buzzer.h"
 #include "Colors.h"
+#include "TargetStore.h"
+#include "flarmnet.h"
+#include "FixMath.h"
 
 #ifndef MAIN_TARGET_H_
 #define MAIN_TARGET_H_
@@ -17,85 +21,106 @@
 #define TASKPERIOD 50  // ms
 #define DISPLAYTICK  5  // all 5 ticks = 250 mS
                                //  5   * 50  = 250 mS -> 1000 / 250 = 4
-#define AGEOUT (30*((1000/((DISPLAYTICK*TASKPERIOD)))))  // 15 seconds
+#define AGEOUT 30000   // ms without PFLAA until a target is removed
+#define ALARM_HOLD 2000       // ms a target stays alarmed after the last alarm PFLAA
+#define BUZZ_HOLDDOWN 3000000 // ms, in effect until the target is twice the buzzer distance away
+
+// Target::dirty, inputs of recalc() changed since the last one
+#define DIRTY_DATA   1   // new PFLAA
+#define DIRTY_COURSE 2   // own ground course
+#define DIRTY_ZOOM   4
+#define DIRTY_SCALE  8   // linear / logarithmic distance
+#define DIRTY_ALL    (DIRTY_DATA | DIRTY_COURSE | DIRTY_ZOOM | DIRTY_SCALE)
+#define DIRTY_GEOM   16  // position or heading moved, triangle to be rebuilt
+
+#define DR_MAX_MS    3000  // dead reckoning horizon behind the last PFLAA
 
 
 
 class Target {
 public:
 	Target();
-	Target( nmea_pflaa_s a_pflaa );
+	Target( nmea_pflaa_s a_pflaa, int a_slot, uint32_t time );
 	virtual ~Target();
-	void ageTarget();
-	void update( nmea_pflaa_s a_pflaa );
-	inline int getAge() { return age; };
+	void extrapolate();   // dead reckoned position and screen geometry of this frame
+	void update( nmea_pflaa_s a_pflaa, uint32_t time );   // time of receipt in ms, see TargetStore::seen
+	inline void setSlot( int a_slot ) { slot = a_slot; };
+	static void beginFrame();   // own course, speed, zoom and scale of this frame, once for all targets
+	static inline uint32_t frameMs() { return frame_ms; };
+	static inline uint32_t takeRecalcs() { uint32_t r = recalcs; recalcs = 0; return r; };
+	inline int getAge() { return std::max( 0, (int)(frame_ms - TargetStore::seen[slot]) ); };   // ms
 	inline int getID() { return pflaa.ID; };
-	inline float getClimb(){ return pflaa.climbRate; };
-	inline float getDist() { return is_nearest ? dist*0.9 : dist; }; // hysteresis 10%
-	inline float getProximity() { return prox; };
+	inline int getClimb(){ return pflaa.climbRate; };   // 1/100 m/s
+	inline float getDist() { return isNearest() ? TargetStore::dist[slot]*0.9 : TargetStore::dist[slot]; }; // hysteresis 10%
+	inline float getProximity() { return TargetStore::prox[slot]; };
 	void dumpInfo();
-	void drawInfo(bool erase=false);
+	void drawInfo();
 	void redrawInfo();
-	void draw(bool erase, bool follow);
+	void draw(bool erase, bool follow);   // adds the symbol to the scene of this frame, see Compositor
+	static void drawText( int x, int y, uint8_t *font, ucg_color_t color, const char *s );
 	void checkClose();
-	inline bool haveAlarm(){ return alarm; };
+	inline bool haveAlarm(){ return TargetStore::flags[slot] & TGT_ALARM; };
 	inline bool sameAlt( uint tolerance=150 ) { return( abs( pflaa.relVertical )< tolerance ); };
-	inline void nearest( bool n ) { is_nearest=n;  updatePriority(); };
-	inline void best( bool n ) { is_best=n; };
-	inline bool isNearest() { return is_nearest; };
-	inline bool isBestClimber() { return is_best; updatePriority();  };
-	inline void updatePriority() {        // mark as priority if this target is either nearest or has an alarm
-	        _isPriority = is_nearest || alarm;
-	}
-	inline bool isPriority() const { return _isPriority; }
+	inline void nearest( bool n ) { TargetStore::setFlag( slot, TGT_NEAREST, n ); };
+	inline void best( bool n ) { TargetStore::setFlag( slot, TGT_BEST, n ); };
+	inline bool isNearest() { return TargetStore::flags[slot] & TGT_NEAREST; };
+	inline bool isBestClimber() { return TargetStore::flags[slot] & TGT_BEST; };
+	inline bool isPriority() { return TargetStore::flags[slot] & (TGT_NEAREST | TGT_ALARM); }  // nearest or alarm
 private:
-	void drawClimb( int x, int y, int size, int climb );
+	void drawClimb( int x, int y, int size, int climb, ucg_color_t color );
 	void checkAlarm();
-	void drawFlarmTarget( int x, int y, int bearing, int sideLength, bool erase=false, bool closest=false, ucg_color_t color={ COLOR_GREEN }, bool follow=false );
+	void drawFlarmTarget( int x, int y, bangle_t bearing, int sideLength, bool erase=false, bool closest=false, ucg_color_t color={ COLOR_GREEN }, bool follow=false );
 	void drawDist( uint8_t r, uint8_t g, uint8_t b );
 	void drawVar( uint8_t r, uint8_t g, uint8_t b );
 	void drawAlt( uint8_t r, uint8_t g, uint8_t b );
 	void drawID( uint8_t r, uint8_t g, uint8_t b );
+	void predict();
 	void recalc();
-	void tekCalc();
+	void tekCalc( uint32_t dt );
 	inline void setAlarm(){
-		alarm = true;
-		alarm_timer = 8;
+		TargetStore::setFlag( slot, TGT_ALARM, true );
+		alarm_ms = frame_ms;
 	};
+	// hot state (age, dist, prox, x, y, flags) lives in TargetStore at slot
+	int slot;
 	nmea_pflaa_s pflaa;
-	int age;
-	int tick;  // 1 sec
-	int raw_tick; // 250 mS
-	int last_pflaa_time;
 	float dist_buzz;
-	int _buzzedHoldDown;
-	int rel_target_heading;
-	float rel_target_dir;
+	bool buzzed;
+	uint32_t buzz_ms;              // time of the last near buzz
+	uint32_t alarm_ms;             // time of the last alarm
+	uint8_t dirty;
+	int rel_n, rel_e, rel_v;       // m, dead reckoned from pflaa
+	bangle_t track;                // dead reckoned
+	bangle_t bearing;              // from own position
+	bangle_t rel_target_heading;   // track relative to own course
+	bangle_t rel_target_dir;       // bearing relative to own course
+	uint16_t dist_m;
+	uint16_t prox_m;
+	int pix;                       // distance on screen
+	int16_t tri[6];                // triangle corners of rel_target_heading at x, y
+	int tri_side;
 	int old_track;
-	float dist, prox;
-	int x,y,old_ax, old_ay, old_x0, old_y0, old_x1, old_y1, old_x2, old_y2, old_closest, old_sidelen, old_cirsize, old_cirsizeteam;
-	char * reg;  // registration from flarmnet DB
-	char * comp; // competition ID
+	char reg[FLARMNET_REG_LEN];  // registration from flarmnet DB, empty if unknown
+	char comp[FLARMNET_CN_LEN];  // competition ID
 
-	bool is_nearest;
-	bool _isPriority; // new: used for draw order priority
 	bool do_follow;
-	bool is_best;
-	bool alarm;
-	bool firstDraw;
-	int alarm_timer;
-	int old_climb;
-	int old_x;
-	int old_y;
-	int old_size;
-	float tek_climb;
-	int last_groundspeed;
+	int tek_climb;          // 1/100 m/s
+	int last_groundspeed;   // m/s
 
 	static char cur_dist[32];
 	static char cur_alt[32];
 	static char cur_id[32];
 	static char cur_var[32];
 
+	// view shared by all targets, see beginFrame()
+	static bangle_t view_course;
+	static int own_vn, own_ve;   // cm/s
+	static uint32_t frame_ms;    // esp_timer, ms as TargetStore::seen
+	static int view_zoom;        // Q8
+	static bool view_log;
+	static uint8_t frame_dirty;
+	static uint32_t recalcs;
+
 	static int old_dist;
 	static unsigned int old_alt;
 	static unsigned int old_id;
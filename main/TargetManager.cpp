@@ -6,6 +6,7 @@
  */
 
 #include "TargetManager.h"
+#include <cstddef>
 #include "inttypes.h"
 #include "Flarm.h"
 #include "Buzzer.h"
@@ -15,31 +16,57 @@
 #include "SetupMenu.h"
 #include "flarmview.h"
 #include "esp_task_wdt.h"
-
-
-std::map< unsigned int, Target> TargetManager::targets;
-std::mutex TargetManager::targets_mutex;
-std::map< unsigned int, Target>::iterator TargetManager::id_iter = targets.begin();
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "Compositor.h"
+#include <eglib/hal/four_wire_spi/esp32/esp32_ili9341.h>
+
+
+uint32_t TargetManager::scan_cycles = 0;
+int TargetManager::scan_count = 0;
+uint32_t TargetManager::update_cycles = 0;
+uint32_t TargetManager::update_count = 0;
+std::mutex TargetManager::snap_mutex;
+target_snapshot_t TargetManager::snapshot[2];
+int TargetManager::snap_front = 0;
+std::atomic<uint32_t> TargetManager::lock_max(0);
+uint32_t TargetManager::compose_cycles = 0;
+uint32_t TargetManager::spi_bytes = 0;
+uint32_t TargetManager::spi_transfers = 0;
+uint32_t TargetManager::glyph_hits = 0;
+uint32_t TargetManager::glyph_misses = 0;
+std::pair<uint32_t, Target*> TargetManager::visible[TARGET_MAX];
+SPSCQueue< traffic_rec_t, TRAFFIC_QUEUE_LEN > TargetManager::traffic;
+unsigned int TargetManager::id_sel = NO_TARGET;
+std::atomic<unsigned int> TargetManager::sel_req(NO_REQUEST);
 extern AdaptUGC *egl;
-float TargetManager::oldN   = -1.0;
 int TargetManager::id_timer =  0;
 int TargetManager::_tick =  0;
+uint32_t TargetManager::close_ms = 0;
 int TargetManager::holddown =  0;
 TaskHandle_t TargetManager::pid = 0;
 unsigned int TargetManager::min_id = 0;
 unsigned int TargetManager::maxcl_id = 0;
 bool TargetManager::redrawNeeded = true;
 bool TargetManager::erase_info = false;
-unsigned int TargetManager::team_id = 0;
+std::atomic<unsigned int> TargetManager::team_id(0);
 int TargetManager::info_timer = 0;
-float TargetManager::old_radius=0.0;
 xSemaphoreHandle _display=NULL;
-Target* TargetManager::theInfoTarget=NULL;
+unsigned int TargetManager::info_id = NO_TARGET;
 int TargetManager::old_num_targets = 0;
 
 #define INFO_TIME (5*(1000/TASKPERIOD)/DISPLAYTICK)  // all ~10 sec
+#define CLOSE_PERIOD 500   // ms between Target::checkClose(), whatever the display rate
+
+static const int frame_ticks[] = { 10, 5, 4, 2 };   // TASKPERIOD ticks per frame, see e_display_rate
+
+static inline int frameTicks(){
+	unsigned int r = display_rate.get();
+	return r < sizeof(frame_ticks)/sizeof(frame_ticks[0]) ? frame_ticks[r] : DISPLAYTICK;
+}
 
 void TargetManager::begin(){
+	Compositor::begin( egl->getEglib(), DISPLAY_W, DISPLAY_H, egl->toColor( COLOR_BLACK ) );
 	xTaskCreatePinnedToCore(&taskTargetMgr, "taskTargetMgr", 4096, NULL, 10, &pid, 0);
 	attach( this );
 }
@@ -47,9 +74,12 @@ void TargetManager::begin(){
 void TargetManager::taskTargetMgr(void *pvParameters){
 	esp_task_wdt_add(NULL);
 	while(1){
+		drainTraffic();  // also while in setup, so the traffic queue never fills up
 		if( !SetupMenu::isActive() ){
 			tick();
 		}
+		else
+			Compositor::invalidate();   // the menu draws over the radar screen
 		esp_task_wdt_reset();
 		delay(TASKPERIOD);
 	}
@@ -62,18 +92,56 @@ TargetManager::TargetManager() {
 
 
 
+static inline int16_t clamp16( int v ){
+	return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+}
+
+// runs in the serial task: no lock, never blocks, the record is applied by the next tick()
 void TargetManager::receiveTarget(const nmea_pflaa_s &pflaa) {
-    if ((pflaa.groundSpeed < 10) && (display_non_moving_target.get() == NON_MOVE_HIDE))
+    if ((pflaa.groundSpeed < 10*NMEA_CENTI) && (display_non_moving_target.get() == NON_MOVE_HIDE))
         return;
-    std::lock_guard<std::mutex> guard(targets_mutex);
-    auto it = targets.find(pflaa.ID);
-    if (it == targets.end()) {
-        it = targets.emplace(pflaa.ID, Target(pflaa)).first;
-    } else {
-        it->second.update(pflaa);
-    }
+    traffic_rec_t rec;
+    rec.ID          = pflaa.ID;
+    rec.relNorth    = pflaa.relNorth;
+    rec.relEast     = pflaa.relEast;
+    rec.relVertical = clamp16( pflaa.relVertical );
+    rec.track       = pflaa.track;
+    rec.turnRate    = clamp16( pflaa.turnRate );
+    rec.groundSpeed = clamp16( pflaa.groundSpeed );
+    rec.climbRate   = clamp16( pflaa.climbRate );
+    rec.alarmLevel  = pflaa.alarmLevel;
+    rec.idType      = pflaa.idType;
+    memcpy( rec.acftType, pflaa.acftType, sizeof(rec.acftType) );
+    rec.time        = esp_timer_get_time()/1000;
+    traffic.push( rec );
+}
 
-    it->second.dumpInfo();
+// apply all records queued since the last tick, runs in the TargetManager task
+// as tick(), the only task touching TargetStore, so neither locks it
+void TargetManager::drainTraffic() {
+    traffic_rec_t rec;
+    while (traffic.pop(rec)) {
+        nmea_pflaa_s pflaa;
+        pflaa.ID          = rec.ID;
+        pflaa.relNorth    = rec.relNorth;
+        pflaa.relEast     = rec.relEast;
+        pflaa.relVertical = rec.relVertical;
+        pflaa.track       = rec.track;
+        pflaa.turnRate    = rec.turnRate;
+        pflaa.groundSpeed = rec.groundSpeed;
+        pflaa.climbRate   = rec.climbRate;
+        pflaa.alarmLevel  = rec.alarmLevel;
+        pflaa.idType      = rec.idType;
+        memcpy( pflaa.acftType, rec.acftType, sizeof(pflaa.acftType) );
+        Target *tgt = TargetStore::find(pflaa.ID);
+        if (tgt) {
+            tgt->update(pflaa, rec.time);
+        } else if (!(tgt = TargetStore::insert(pflaa, rec.time))) {
+            ESP_LOGW(FNAME, "Target table full, %06X dropped", pflaa.ID);
+            continue;
+        }
+        tgt->dumpInfo();
+    }
 }
 
 TargetManager::~TargetManager() {
@@ -81,20 +149,13 @@ TargetManager::~TargetManager() {
 	vSemaphoreDelete(_display);
 }
 
-void TargetManager::drawN( int x, int y, bool erase, float north, float dist ){
+void TargetManager::drawN( int x, int y, float north, float dist ){
   if (!egl) return;
   if( SetupMenu::isActive() )
 		return;
 	// ESP_LOGI(FNAME,"drawAirplane x:%d y:%d small:%d", x, y, smallSize );
 	egl->setFontPosCenter();
-	egl->setPrintPos( x-dist*sin(D2R(north))-5, y-dist*cos(D2R(north))+6 );
-	egl->setFont(ucg_font_ncenR14_hr);
-	if(erase)
-		egl->setColor(COLOR_BLACK);
-	else
-		egl->setColor(COLOR_GREEN);
-	egl->print("N");
-	oldN = north;
+	Target::drawText( x-dist*sin(D2R(north))-5, y-dist*cos(D2R(north))+6, ucg_font_ncenR14_hr, { COLOR_GREEN }, "N" );
 }
 
 void TargetManager::drawAirplane(int x, int y, float north) {
@@ -103,11 +164,11 @@ void TargetManager::drawAirplane(int x, int y, float north) {
 
     DisplayLock lock(_display);
 
-    // --- Draw airplane body ---
-    egl->setColor(COLOR_WHITE);
-    egl->drawTetragon(x - 15, y - 1, x - 15, y + 1, x + 15, y + 1, x + 15, y - 1);
-    egl->drawTetragon(x - 1, y + 10, x - 1, y - 6, x + 1, y - 6, x + 1, y + 10);
-    egl->drawTetragon(x - 4, y + 10, x - 4, y + 9, x + 4, y + 9, x + 4, y + 10);
+    // --- Airplane body ---
+    color_t white = egl->toColor(COLOR_WHITE);
+    Compositor::tetragon(x - 15, y - 1, x - 15, y + 1, x + 15, y + 1, x + 15, y - 1, white);
+    Compositor::tetragon(x - 1, y + 10, x - 1, y - 6, x + 1, y - 6, x + 1, y + 10, white);
+    Compositor::tetragon(x - 4, y + 10, x - 4, y + 9, x + 4, y + 9, x + 4, y + 10, white);
 
     // --- Compute new radius ---
     float new_radius;
@@ -118,25 +179,9 @@ void TargetManager::drawAirplane(int x, int y, float north) {
         new_radius = 25.0f;
     }
 
-    // --- Redraw orientation and circle if changed ---
-    constexpr float EPS_N = 0.5f;
-    float delta = fabsf(fmodf(north - oldN + 540.0f, 360.0f) - 180.0f);
-    bool needRedraw = (oldN == -1.0f) || delta > EPS_N || fabsf(old_radius - new_radius) > 0.5f || !(_tick %20);
-
-    if (needRedraw) {
-        if (oldN != -1.0f)
-            drawN(x, y, true, oldN, old_radius);
-
-        if (old_radius > 0.0f)
-            egl->drawCircle(x, y, old_radius);
-
-        egl->setColor(COLOR_GREEN);
-        drawN(x, y, false, north, new_radius);
-        egl->drawCircle(x, y, new_radius);
-
-        oldN = north;
-        old_radius = new_radius;
-    }
+    // --- Orientation and range circle, sent only when they moved ---
+    drawN(x, y, north, new_radius);
+    Compositor::circle(x, y, new_radius, egl->toColor(COLOR_GREEN));
 }
 
 
@@ -179,22 +224,80 @@ void TargetManager::printAlarmLevel( const char*alarm, int x, int y, int level )
 	egl->printf( alarm );
 }
 
+// IDs in ascending order, as TargetStore::next()
+static unsigned int snapNext( const target_snapshot_t &s, unsigned int after ){
+	unsigned int best = NO_TARGET;
+	for( int i=0; i<s.num; i++ ){
+		if( s.id[i] > after && s.id[i] < best )
+			best = s.id[i];
+	}
+	return best;
+}
+
+static void lockMax( std::atomic<uint32_t> &max, uint32_t cycles ){
+	uint32_t m = max.load();
+	while( cycles > m && !max.compare_exchange_weak( m, cycles ) )
+		;
+}
+
+// Runs in the switch task, works on a copy of the published target list and
+// posts the selection, id_sel is only written by the TargetManager task
 void TargetManager::nextTarget(int timer){
-	// ESP_LOGI(FNAME,"nextTarget size:%d", targets.size() );
-	std::lock_guard<std::mutex> guard(targets_mutex);
-	if( targets.size() ){
-		if( ++id_iter == targets.end() )
-			id_iter = targets.begin();
-		if( (timer == 0) && (id_iter != targets.end()) ){ // move away on first call from closest (displayed per default)
-			if( id_iter->first == min_id ){
-				if( ++id_iter == targets.end() )
-					id_iter = targets.begin();
+	static target_snapshot_t s;
+	readSnapshot( s );
+	unsigned int cur = sel_req.load();
+	if( cur == NO_REQUEST )   // else a press not yet applied
+		cur = s.selected;
+	unsigned int sel = cur;
+	if( s.num ){
+		sel = snapNext( s, cur );
+		if( sel == NO_TARGET )
+			sel = snapNext( s, 0 );
+		if( timer == 0 ){ // move away on first call from closest (displayed per default)
+			if( sel == s.nearest ){
+				if( (sel = snapNext( s, sel )) == NO_TARGET )
+					sel = snapNext( s, 0 );
 			}
 		}
-		if( id_iter != targets.end() ){
-			ESP_LOGI( FNAME, "next target: %06X",id_iter->first );
-		}
+		ESP_LOGI( FNAME, "next target: %06X", sel );
 	}
+	sel_req.store( sel );
+}
+
+// the selection of the last press(), if any, in the TargetManager task
+void TargetManager::applySelection(){
+	unsigned int sel = sel_req.exchange( NO_REQUEST );
+	if( sel == NO_REQUEST )
+		return;
+	id_sel = sel;
+	id_timer = 10 * (1000/TASKPERIOD);  // 10 seconds
+	holddown = 5;
+}
+
+// the back snapshot is only written here, by the TargetManager task, the lock
+// covers the swap only
+void TargetManager::publishSnapshot(){
+	int back = !snap_front;
+	target_snapshot_t &s = snapshot[back];
+	s.epoch = snapshot[snap_front].epoch + 1;
+	s.num = TargetStore::size();
+	s.nearest = min_id;
+	s.selected = id_sel;
+	s.info = info_id;
+	memcpy( s.id, TargetStore::id, s.num*sizeof(s.id[0]) );
+	uint32_t start = esp_cpu_get_ccount();
+	std::lock_guard<std::mutex> guard(snap_mutex);
+	snap_front = back;
+	lockMax( lock_max, esp_cpu_get_ccount() - start );
+}
+
+// copy of the published snapshot, the lock covers the copy of num IDs only
+void TargetManager::readSnapshot( target_snapshot_t &s ){
+	uint32_t start = esp_cpu_get_ccount();
+	std::lock_guard<std::mutex> guard(snap_mutex);
+	const target_snapshot_t &f = snapshot[snap_front];
+	memcpy( &s, &f, offsetof(target_snapshot_t, id) + f.num*sizeof(f.id[0]) );
+	lockMax( lock_max, esp_cpu_get_ccount() - start );
 }
 
 void TargetManager::printVersions( int x, int y, const char *prefix, const char *ver, int erase ){
@@ -214,6 +317,7 @@ void TargetManager::printVersions( int x, int y, const char *prefix, const char
 void TargetManager::clearScreen(){
 	DisplayLock lock(_display);
 	egl->clearScreen();
+	Compositor::invalidate();
 	// redrawNeeded = true;
 }
 
@@ -229,21 +333,21 @@ void TargetManager::rewindInfoTimer(){
 void TargetManager::press() {
 	ESP_LOGI(FNAME,"press()");
 	if( display_mode.get() == DISPLAY_MULTI ){
-		id_timer = 10 * (1000/TASKPERIOD);  // 10 seconds
-		holddown=5;
-		nextTarget( id_timer );
+		nextTarget( 10 * (1000/TASKPERIOD) );   // selection timer, set by applySelection()
 	}
 };
 
+// switch task, selected and info target as published with the last frame
 void TargetManager::longLongPress() {
-	std::lock_guard<std::mutex> guard(targets_mutex);
-	if( id_iter != targets.end() ){
-		team_id = id_iter->first;
-		ESP_LOGI(FNAME,"long long press: target ID locked: %X", team_id );
+	static target_snapshot_t s;
+	readSnapshot( s );
+	if( s.selected != NO_TARGET ){
+		team_id = s.selected;
+		ESP_LOGI(FNAME,"long long press: target ID locked: %X", s.selected );
 	}else{
-		if( theInfoTarget ){
-			ESP_LOGI(FNAME,"long long press: nothing selected so fas, use closest: %X", theInfoTarget->getID() );
-			team_id = theInfoTarget->getID();
+		if( s.info != NO_TARGET ){
+			ESP_LOGI(FNAME,"long long press: nothing selected so fas, use closest: %X", s.info );
+			team_id = s.info;
 		}else{
 			ESP_LOGI(FNAME,"No target");
 		}
@@ -366,19 +470,18 @@ void TargetManager::handleFlarmFlags() {
 
 void TargetManager::tick() {
     _tick++;
-    float min_dist   = 10000.0f;
-    float max_climb  = -1000.0f;
     maxcl_id = 0;
     min_id = 0;
 
     // --- Update timers ---
+    applySelection();
     if (holddown > 0) holddown--;
     if (id_timer  > 0) id_timer--;
     if (info_timer > 0) info_timer--;
 
     // --- Periodic logging / redraw trigger ---
     if (!(_tick % 20)) { // ~1 s
-    	int num=(int)targets.size();
+    	int num=TargetStore::size();
     	if( num != old_num_targets ){
     		ESP_LOGI(FNAME, "Num targets: %d", num );
     		old_num_targets = num;
@@ -387,108 +490,131 @@ void TargetManager::tick() {
     if (!(_tick % 30)) { // ~1.5 s
         redrawNeeded = true;
     }
+    if (!(_tick % 200)) { // ~10 s, repairs what status texts drew over the radar screen
+        Compositor::refresh();
+    }
 
-    // --- Main tick block (every 5 ticks ~250 ms) ---
-    if (_tick % 5 != 0) return;
     if (SetupMenu::isActive()) return;
 
+    // --- Main tick block (every frame, display_rate) ---
+    const int frame = frameTicks();
+    if (_tick % frame) return;
+    bool close_tick = false;   // first frame of each CLOSE_PERIOD
+
     handleFlarmFlags();
 
     const bool flarm_ok = (!info_timer && Flarm::connected());
     if (flarm_ok) {
+        Compositor::beginFrame();
         drawAirplane(DISPLAY_W / 2, DISPLAY_H / 2, Flarm::getGndCourse());
     }
 
-    // --- Pass 1: Determine nearest and max climb ---
+    // --- Pass 1: Determine nearest (highest threat) and max climb ---
     {
-    	std::lock_guard<std::mutex> guard(targets_mutex);
-    	for (auto &kv : targets) {
-    		Target &tgt = kv.second;
-    		tgt.ageTarget();
-    		tgt.nearest(false);
-    		tgt.best(false);
-
-    		if (tgt.getAge() < AGEOUT) {
-    			if (tgt.haveAlarm()) id_timer = 0;
-
-    			if (tgt.getClimb() > max_climb) {
-    				max_climb = tgt.getClimb();
-    				maxcl_id = kv.first;
-    			}
-
-    			if (!id_timer) {
-    				if (tgt.getProximity() < min_dist) {
-    					min_dist = tgt.getDist();
-    					min_id = kv.first;
-    					id_iter = targets.end(); // deselect again
-    				}
-    			} else if (id_iter != targets.end() && kv.first == id_iter->first) {
-    				tgt.nearest(true);
-    			}
+    	int num = TargetStore::size();
+    	uint32_t start = esp_cpu_get_ccount();
+    	Target::beginFrame();   // own course, speed, zoom and scale once for all targets
+    	uint32_t now = Target::frameMs();
+    	if (now - close_ms >= CLOSE_PERIOD) {
+    		close_tick = true;
+    		close_ms += CLOSE_PERIOD;   // keeps the cadence on average at any frame rate
+    		if (now - close_ms >= CLOSE_PERIOD)
+    			close_ms = now;         // after a pause, no catching up
+    	}
+    	for (int i = 0; i < num; i++)
+    		TargetStore::at(i).extrapolate();   // position of this frame into the hot arrays
+    	update_cycles += esp_cpu_get_ccount() - start;
+    	update_count += num;
+
+    	// threat per target, the nearest and best climber come from the store's index
+    	start = esp_cpu_get_ccount();
+    	TargetStore::computeCPA(now);
+    	if (TargetStore::alarmed()) id_timer = 0;
+    	int best = TargetStore::bestClimber(now);
+    	if (best >= 0)
+    		maxcl_id = TargetStore::id[best];
+    	if (!id_timer) {
+    		int nearest = TargetStore::nearest();
+    		if (nearest >= 0) {
+    			min_id = TargetStore::id[nearest];
+    			id_sel = NO_TARGET; // deselect again
     		}
     	}
+    	scan_cycles += esp_cpu_get_ccount() - start;
+    	if (++scan_count >= 60000/(frame*TASKPERIOD)) { // ~1 min
+    		ESP_LOGI(FNAME, "Scan %d targets: %u cycles, store %u bytes, update %u cycles/target, %u recalcs/s, lock max %u cycles", num, scan_cycles/scan_count,
+    				TargetStore::memoryUsed(), update_count ? update_cycles/update_count : 0, Target::takeRecalcs()/60, lock_max.load());
+    		ESP_LOGI(FNAME, "Frame: SPI %u bytes in %u transfers, %u rects, %u pixels, compose %u cycles, %u dropped", (esp32_ili9341_bytes-spi_bytes)/scan_count,
+    				(esp32_ili9341_transfers-spi_transfers)/scan_count, Compositor::takeRects()/scan_count, Compositor::takePixels()/scan_count,
+    				compose_cycles/scan_count, Compositor::takeDropped());
+    		ESP_LOGI(FNAME, "Glyphs: %u from the cache, %u rendered", eglib_glyph_hits-glyph_hits, eglib_glyph_misses-glyph_misses);
+    		spi_bytes = esp32_ili9341_bytes;
+    		spi_transfers = esp32_ili9341_transfers;
+    		glyph_hits = eglib_glyph_hits;
+    		glyph_misses = eglib_glyph_misses;
+    		compose_cycles = 0;
+    		lock_max = 0;
+    		scan_cycles = 0;
+    		scan_count = 0;
+    		update_cycles = 0;
+    		update_count = 0;
+    	}
     }
 
     // --- Pass 2: Draw all visible targets ---
     if (flarm_ok) {
-        std::vector<std::pair<uint32_t, Target*>> visible;
-        std::lock_guard<std::mutex> guard(targets_mutex);
-        // Collect visible targets
-        for (auto it = targets.begin(); it != targets.end();) {
-            Target &tgt = it->second;
-            tgt.best(it->first == maxcl_id);
-            if (!id_timer) tgt.nearest(it->first == min_id);
-
-            bool displayTarget = (tgt.getAge() < AGEOUT) &&
+        auto displayTarget = [](Target &tgt) {
+            return (tgt.getAge() < AGEOUT) &&
                 ((display_mode.get() == DISPLAY_MULTI) ||
                  ((display_mode.get() == DISPLAY_SIMPLE) && tgt.isNearest()));
-
-            if (displayTarget) {
-                visible.emplace_back(it->first, &tgt);
-                ++it;
-            } else {
-                // --- Remove invisible / aged-out target ---
-                // Do NOT erase the info target here
-                if (theInfoTarget && it->first == theInfoTarget->getID()) {
-                    ++it; // skip erasing, keep info on screen
-                } else {
-                    if (id_iter != targets.end() && it->first == id_iter->first) id_iter++;
-                    tgt.draw(true, it->first == team_id);
-                    it = targets.erase(it);
-                }
-            }
+        };
+        // --- Remove invisible / aged-out targets ---
+        // erase moves entries, so collect first and erase after the walk
+        unsigned int gone[TARGET_MAX];
+        int num_gone = 0;
+        for (int i = 0; i < TargetStore::size(); i++) {
+            Target &tgt = TargetStore::at(i);
+            unsigned int id = TargetStore::id[i];
+            tgt.best(id == maxcl_id);
+            tgt.nearest(id == (id_timer ? id_sel : min_id));
+            // Do NOT erase the info target here, keep info on screen
+            if (!displayTarget(tgt) && id != info_id)
+                gone[num_gone++] = id;   // left out of the scene, so erased
+        }
+        for (int i = 0; i < num_gone; i++) {
+            if (gone[i] == id_sel) id_sel = TargetStore::next(id_sel);
+            TargetStore::erase(gone[i]);
+        }
+        // Collect visible targets, references stay valid until the next erase
+        int num_visible = 0;
+        for (int i = 0; i < TargetStore::size(); i++) {
+            if (displayTarget(TargetStore::at(i)))
+                visible[num_visible++] = std::make_pair(TargetStore::id[i], &TargetStore::at(i));
         }
 
         // --- Select exactly one info/priority target ---
         Target* infoTarget = nullptr;
         uint32_t infoId = 0;
 
-        if (!visible.empty()) {
-            // 1) alarmed first
-            for (auto &p : visible) if (p.second->haveAlarm()) { infoTarget = p.second; infoId = p.first; break; }
-            // 2) nearest
-            if (!infoTarget) for (auto &p : visible) if (p.second->isNearest()) { infoTarget = p.second; infoId = p.first; break; }
-
-        }
+        // 1) alarmed first
+        for (int v = 0; v < num_visible && !infoTarget; v++)
+            if (visible[v].second->haveAlarm()) { infoTarget = visible[v].second; infoId = visible[v].first; }
+        // 2) nearest by threat, closing targets first
+        for (int v = 0; v < num_visible && !infoTarget; v++)
+            if (visible[v].second->isNearest()) { infoTarget = visible[v].second; infoId = visible[v].first; }
 
         // --- Draw all normal targets first (without info) ---
-        for (auto &p : visible) {
+        for (int v = 0; v < num_visible; v++) {
+            auto &p = visible[v];
             if (p.first == infoId) continue; // skip priority target
             Target &tgt = *p.second;
             tgt.draw(false, p.first == team_id);
-            if (!(_tick % 2)) tgt.checkClose();
-            // Do NOT call drawInfo(false) here — prevents flashing
+            if (close_tick) tgt.checkClose();
         }
 
         // --- Draw the priority target last (on top) ---
         if (infoTarget) {
-            // Check if priority target changed
-            if (theInfoTarget && theInfoTarget != infoTarget) {
-                // erase old info
-                theInfoTarget->drawInfo(true);
-            }
-
-            theInfoTarget = infoTarget;
+            info_id = infoId;   // the info of a former one is no longer in the scene
 
             // Redraw info if needed
             if (redrawNeeded) {
@@ -499,16 +625,20 @@ void TargetManager::tick() {
             infoTarget->drawInfo();  // show info
             infoTarget->draw(false, infoId == team_id);
             min_id = infoId;
-            if (!(_tick % 2)) infoTarget->checkClose();
+            if (close_tick) infoTarget->checkClose();
 
         } else {
-            // no info target, erase previous if exists
-            if (theInfoTarget) {
-                theInfoTarget->drawInfo(true);
-                theInfoTarget = nullptr;
-            }
+            info_id = NO_TARGET;
         }
 
+        // --- Send what changed since the last frame ---
+        uint32_t start = esp_cpu_get_ccount();
+        {
+            DisplayLock lock(_display);
+            Compositor::endFrame();
+        }
+        compose_cycles += esp_cpu_get_ccount() - start;
     }
+    publishSnapshot();
     printRX();
 }
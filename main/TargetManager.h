@@ -6,21 +6,56 @@
  */
 
 #include "Flarm.h"
-#include <map>
 #include "Target.h"
 #include "Switch.h"
 #include <mutex>
+#include <atomic>
+#include <utility>
+#include "SPSCQueue.h"
 
 #ifndef MAIN_TARGETMANAGER_H_
 #define MAIN_TARGETMANAGER_H_
 
 
+#define TRAFFIC_QUEUE_LEN 32   // PFLAA records between two ticks, power of two
+
+// compact PFLAA record handed from the serial task to the TargetManager task
+typedef struct {
+	uint32_t ID;
+	int32_t  relNorth;      // m
+	int32_t  relEast;       // m
+	int16_t  relVertical;   // m
+	uint16_t track;         // deg
+	int16_t  turnRate;      // 1/100 deg/s
+	int16_t  groundSpeed;   // 1/100 m/s
+	int16_t  climbRate;     // 1/100 m/s
+	uint8_t  alarmLevel;
+	uint8_t  idType;
+	char     acftType[3];
+	uint32_t time;          // ms, esp_timer at receipt
+} traffic_rec_t;
+
+// compact copy of the target list for the other tasks (button handling),
+// published once per frame, see TargetManager::publishSnapshot()
+typedef struct {
+	uint32_t     epoch;            // frame
+	int          num;
+	unsigned int nearest;          // ID shown as nearest, 0 if none
+	unsigned int selected;         // id_sel, NO_TARGET if none
+	unsigned int info;             // info_id, NO_TARGET if none
+	unsigned int id[TARGET_MAX];
+} target_snapshot_t;
+
+#define NO_REQUEST 0xFFFFFFFEu   // in sel_req, neither a FLARM ID nor NO_TARGET
+
 class TargetManager: public SwitchObserver {
 public:
 	TargetManager();
 	~TargetManager();
 	static void receiveTarget( const nmea_pflaa_s &target );
 	static void tick();
+	static inline uint32_t getQueueOverflow() { return traffic.getOverflow(); };
+	static inline uint32_t getQueueHighWater() { return traffic.getHighWater(); };
 	static void drawAirplane( int x, int y, float north=0.0 );
 	void begin();
 	inline static void redrawInfo() { redrawNeeded = true; };
@@ -39,11 +74,28 @@ public:
 
 private:
 	static TargetManager* instance;
-	static std::map< unsigned int, Target> targets;
-	static std::mutex targets_mutex;
-	static std::map< unsigned int, Target>::iterator id_iter;
-	static float oldN;
-	static void drawN( int x, int y, bool erase, float north, float azoom );
+	static uint32_t scan_cycles;    // nearest / best climber scan, logged every minute
+	static int scan_count;
+	static uint32_t update_cycles;  // Target::extrapolate() incl. recalc(), per target
+	static uint32_t update_count;
+	static std::mutex snap_mutex;   // held for the swap and the copy of a snapshot only
+	static target_snapshot_t snapshot[2];
+	static int snap_front;          // published one, the other is written by tick()
+	static std::atomic<uint32_t> lock_max;  // longest hold of snap_mutex in cycles, logged every minute
+	static uint32_t compose_cycles; // Compositor::endFrame(), incl. the SPI transfers
+	static uint32_t spi_bytes;      // esp32_ili9341_bytes at the last log
+	static uint32_t spi_transfers;  // esp32_ili9341_transfers at the last log
+	static uint32_t glyph_hits;     // eglib_glyph_hits at the last log
+	static uint32_t glyph_misses;   // eglib_glyph_misses at the last log
+	static void publishSnapshot();
+	static void readSnapshot( target_snapshot_t &s );
+	static std::pair<uint32_t, Target*> visible[TARGET_MAX];   // of the frame, reused
+	static SPSCQueue< traffic_rec_t, TRAFFIC_QUEUE_LEN > traffic;  // serial task -> tick()
+	static void drainTraffic();
+	static unsigned int id_sel;     // target selected by press(), NO_TARGET if none
+	static std::atomic<unsigned int> sel_req;  // selection posted by press(), applied by tick()
+	static void applySelection();
+	static void drawN( int x, int y, float north, float azoom );
 	static void printAlarm( const char*alarm, int x, int y, bool print, ucg_color_t color={ COLOR_RED } );
 	static void printAlarmLevel( const char*alarm, int x, int y, int level );
 	static void printRX();
@@ -53,6 +105,7 @@ private:
 	static void clearScreen();
 	static void rewindInfoTimer();
 	static int id_timer;
+	static uint32_t close_ms;       // Target::frameMs() the last Target::checkClose() was due
 	static int _tick;
 	static int holddown;
 	static TaskHandle_t pid;
@@ -62,9 +115,8 @@ private:
 	static bool erase_info;
 	static int info_timer;
 	static int old_num_targets;
-	static float old_radius;
-	static unsigned int team_id;
-	static Target* theInfoTarget;
+	static std::atomic<unsigned int> team_id;   // set by longLongPress()
+	static unsigned int info_id;    // target showing its info, NO_TARGET if none
 };
 
 #endif /* MAIN_TARGETMANAGER_H_ */
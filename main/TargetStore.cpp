@@ -0,0 +1,237 @@
+/*
+ * TargetStore.cpp
+ *
+ */
+
+#include "TargetStore.h"
+#include "Target.h"
+#include "FixMath.h"
+
+unsigned int TargetStore::id[TARGET_MAX];
+float    TargetStore::dist[TARGET_MAX];
+float    TargetStore::prox[TARGET_MAX];
+int16_t  TargetStore::x[TARGET_MAX];
+int16_t  TargetStore::y[TARGET_MAX];
+uint32_t TargetStore::seen[TARGET_MAX];
+int      TargetStore::climb[TARGET_MAX];
+int16_t  TargetStore::rn[TARGET_MAX];
+int16_t  TargetStore::re[TARGET_MAX];
+int16_t  TargetStore::rv[TARGET_MAX];
+int16_t  TargetStore::vn[TARGET_MAX];
+int16_t  TargetStore::ve[TARGET_MAX];
+uint16_t TargetStore::cpa[TARGET_MAX];
+uint8_t  TargetStore::tcpa[TARGET_MAX];
+uint16_t TargetStore::threat[TARGET_MAX];
+uint8_t  TargetStore::flags[TARGET_MAX];
+TargetTable< uint8_t, TARGET_TABLE_SLOTS > TargetStore::index;
+Target TargetStore::cold[TARGET_MAX];
+int TargetStore::num = 0;
+uint8_t TargetStore::heap[TARGET_MAX];
+uint8_t TargetStore::heap_pos[TARGET_MAX];
+int TargetStore::best = -1;
+bool TargetStore::best_stale = false;
+int TargetStore::alarms = 0;
+
+Target *TargetStore::find( unsigned int tid ){
+	uint8_t *i = index.find( tid );
+	return i ? &cold[*i] : nullptr;
+}
+
+Target *TargetStore::insert( const nmea_pflaa_s &pflaa, uint32_t time ){
+	if( num >= TARGET_MAX || !index.insert( pflaa.ID, (uint8_t)num ) )
+		return nullptr;
+	threat[num] = UINT16_MAX;   // until the next computeCPA()
+	heap[num] = num;
+	heap_pos[num] = num;
+	cold[num] = Target( pflaa, num, time );   // sets up the hot state at num too
+	return &cold[num++];
+}
+
+bool TargetStore::erase( unsigned int tid ){
+	uint8_t *p = index.find( tid );
+	if( !p )
+		return false;
+	int i = *p;
+	index.erase( tid );
+	if( flags[i] & TGT_ALARM )
+		alarms--;
+	int last = --num;
+	int hp = heap_pos[i];
+	if( hp != num ){  // the last heap entry fills the gap
+		int moved = heap[num];
+		heap[hp] = moved;
+		heap_pos[moved] = hp;
+		siftUp( hp );
+		siftDown( heap_pos[moved] );
+	}
+	if( best == i ){
+		best = -1;
+		best_stale = true;
+	}
+	else if( best == last )
+		best = i;
+	if( i != last ){  // keep dense: move the last target into the hole
+		id[i]    = id[last];
+		dist[i]  = dist[last];
+		prox[i]  = prox[last];
+		x[i]     = x[last];
+		y[i]     = y[last];
+		seen[i]  = seen[last];
+		climb[i] = climb[last];
+		rn[i]    = rn[last];
+		re[i]    = re[last];
+		rv[i]    = rv[last];
+		vn[i]    = vn[last];
+		ve[i]    = ve[last];
+		cpa[i]   = cpa[last];
+		tcpa[i]  = tcpa[last];
+		threat[i] = threat[last];
+		flags[i] = flags[last];
+		cold[i]  = cold[last];
+		cold[i].setSlot( i );
+		*index.find( id[i] ) = i;
+		heap_pos[i] = heap_pos[last];
+		heap[heap_pos[i]] = i;
+	}
+	return true;
+}
+
+static inline int clampRel( int v ){
+	return v > 30000 ? 30000 : (v < -30000 ? -30000 : v);
+}
+
+// Closest point of approach of all targets, from the relative position and
+// velocity of this frame, straight flight assumed. Same integer work for every
+// target, two square roots and one division, no iteration, so the cost grows
+// linearly with the number of targets:
+//   tcpa = -(r.v)/|v|^2, horizontal miss distance |r x v|/|v|, vertical
+//   from the climb at tcpa. Moving apart: tcpa 0, cpa the distance now.
+// threat ranks targets for the info display: the distance now, or if an
+// approach comes closer, its distance plus CPA_WEIGHT m for every second
+// until then. A head-on target at 1.5 km closing at 100 m/s (15 s, 150 m)
+// ranks before a glider circling at 300 m.
+void TargetStore::computeCPA( uint32_t now ){
+	for( int i=0; i<num; i++ ){
+		if( (int)(now - seen[i]) >= AGEOUT ){
+			setThreat( i, UINT16_MAX );
+			continue;
+		}
+		int n = rn[i], e = re[i], v = rv[i];
+		int dn = vn[i], de = ve[i];
+		uint32_t dnow = fixSqrt( (uint32_t)(n*n) + (uint32_t)(e*e) + (uint32_t)(v*v) );
+		int dot = n*dn + e*de;                    // m dm/s, |v| < CPA_VMAX keeps 10*dot in 32 bit
+		uint32_t vv = (uint32_t)(dn*dn + de*de);  // (dm/s)^2
+		uint32_t t = 0;
+		uint32_t miss = dnow;
+		if( dot < 0 && vv ){
+			t = ((uint32_t)-dot * 10) / vv;       // s
+			int cn, ce;
+			if( t < CPA_HORIZON ){
+				int cross = n*de - e*dn;
+				uint32_t h = (uint32_t)(cross < 0 ? -cross : cross) / fixSqrt( vv );   // m
+				cn = h; ce = 0;
+			}
+			else {
+				t = CPA_HORIZON;
+				cn = clampRel( n + dn*CPA_HORIZON/10 );
+				ce = clampRel( e + de*CPA_HORIZON/10 );
+			}
+			int cv = clampRel( v + climb[i]*(int)t/100 );
+			miss = fixSqrt( (uint32_t)(cn*cn) + (uint32_t)(ce*ce) + (uint32_t)(cv*cv) );
+		}
+		cpa[i] = miss > UINT16_MAX ? UINT16_MAX : miss;
+		tcpa[i] = t;
+		uint32_t th = miss + CPA_WEIGHT*t;
+		if( th > dnow )
+			th = dnow;
+		setThreat( i, th >= UINT16_MAX ? UINT16_MAX-1 : th );
+	}
+}
+
+void TargetStore::setThreat( int i, uint16_t t ){
+	uint16_t old = threat[i];
+	if( t == old )
+		return;
+	threat[i] = t;
+	if( t < old )
+		siftUp( heap_pos[i] );
+	else
+		siftDown( heap_pos[i] );
+}
+
+void TargetStore::siftUp( int p ){
+	int i = heap[p];
+	uint16_t t = threat[i];
+	while( p ){
+		int q = (p-1)/2;
+		if( threat[heap[q]] <= t )
+			break;
+		heap[p] = heap[q];
+		heap_pos[heap[p]] = p;
+		p = q;
+	}
+	heap[p] = i;
+	heap_pos[i] = p;
+}
+
+void TargetStore::siftDown( int p ){
+	int i = heap[p];
+	uint16_t t = threat[i];
+	for(;;){
+		int c = 2*p+1;
+		if( c >= num )
+			break;
+		if( c+1 < num && threat[heap[c+1]] < threat[heap[c]] )
+			c++;
+		if( threat[heap[c]] >= t )
+			break;
+		heap[p] = heap[c];
+		heap_pos[heap[p]] = p;
+		p = c;
+	}
+	heap[p] = i;
+	heap_pos[i] = p;
+}
+
+void TargetStore::setClimb( int i, int c ){
+	int old = climb[i];
+	climb[i] = c;
+	if( best_stale )
+		return;
+	if( best < 0 || c > climb[best] )
+		best = i;
+	else if( i == best && c < old )
+		best_stale = true;   // may have been overtaken
+}
+
+int TargetStore::bestClimber( uint32_t now ){
+	if( best >= 0 && (int)(now - seen[best]) >= AGEOUT )
+		best_stale = true;
+	if( best_stale ){
+		best = -1;
+		for( int i=0; i<num; i++ ){
+			if( (int)(now - seen[i]) < AGEOUT && (best < 0 || climb[i] > climb[best]) )
+				best = i;
+		}
+		best_stale = false;
+	}
+	return best;
+}
+
+unsigned int TargetStore::next( unsigned int after ){
+	unsigned int best = NO_TARGET;
+	for( int i=0; i<num; i++ ){
+		if( id[i] > after && id[i] < best )
+			best = id[i];
+	}
+	return best;
+}
+
+unsigned int TargetStore::first(){
+	unsigned int best = NO_TARGET;
+	for( int i=0; i<num; i++ ){
+		if( id[i] < best )
+			best = id[i];
+	}
+	return best;
+}
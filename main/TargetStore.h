@@ -0,0 +1,103 @@
+/*
+ * TargetStore.h
+ *
+ * Fixed size store of all FLARM targets, split hot and cold.
+ *
+ * The per tick state (ID, distance, proximity, screen position, last seen, climb,
+ * relative motion, closest point of approach and flags) is kept as structure of arrays, densely packed in index
+ * 0..size()-1, so the nearest / best climber scan of TargetManager::tick()
+ * walks a few contiguous arrays only. Everything used for drawing (erase
+ * bookkeeping, flarmnet strings, the last PFLAA) stays in the Target objects,
+ * the cold part, stored at the same index.
+ *
+ * erase() moves the last target into the hole, so indices and Target
+ * references are only valid until the next erase().
+ *
+ * Only the TargetManager task touches the store, other tasks see the IDs
+ * through the snapshot published by TargetManager::publishSnapshot().
+ *
+ * The nearest target and the best climber are kept up to date as the data
+ * changes, not searched per frame: an indexed binary min-heap of the indices
+ * ordered by threat, updated by setThreat() in O(log n), and the index of
+ * the best climber, updated by setClimb(), searched again only when it
+ * sinks, leaves or ages out.
+ */
+
+#ifndef MAIN_TARGETSTORE_H_
+#define MAIN_TARGETSTORE_H_
+
+#include <cstdint>
+#include "NMEA.h"
+#include "TargetTable.h"
+
+class Target;
+
+#define TARGET_MAX (TARGET_TABLE_SLOTS*3/4)   // same load limit as TargetTable
+
+// TargetStore::flags
+#define TGT_NEAREST 1
+#define TGT_BEST    2
+#define TGT_ALARM   4
+
+#define CPA_HORIZON    120   // s, approaches further ahead count from the position then
+#define CPA_WEIGHT     10    // m of threat per second to the closest point of approach
+#define CPA_BUZZ_TIME  30    // s, see Target::checkClose()
+#define CPA_VMAX       6000  // dm/s, limit of vn, ve
+
+class TargetStore {
+public:
+	static Target *find( unsigned int id );
+	static Target *insert( const nmea_pflaa_s &pflaa, uint32_t time );   // nullptr if the store is full
+	static bool erase( unsigned int id );
+	static inline int size() { return num; };
+	static inline Target &at( int i ) { return cold[i]; };
+	static unsigned int next( unsigned int after );       // IDs in ascending order
+	static unsigned int first();
+	static inline void setFlag( int i, uint8_t f, bool on ) {
+		uint8_t old = flags[i];
+		flags[i] = on ? (old | f) : (old & ~f);
+		if( (old ^ flags[i]) & TGT_ALARM )
+			alarms += on ? 1 : -1;
+	};
+	static inline int alarmed() { return alarms; };   // targets with TGT_ALARM
+	static void setClimb( int i, int c );
+	static inline int nearest() { return num && threat[heap[0]] < UINT16_MAX ? heap[0] : -1; };   // lowest threat, -1 if none
+	static int bestClimber( uint32_t now );           // -1 if none
+	static inline size_t memoryUsed() { return sizeof(index) + sizeof(cold) + sizeof(id) + sizeof(dist) + sizeof(prox) +
+			sizeof(x) + sizeof(y) + sizeof(seen) + sizeof(climb) + sizeof(rn) + sizeof(re) + sizeof(rv) + sizeof(vn) + sizeof(ve) +
+			sizeof(cpa) + sizeof(tcpa) + sizeof(threat) + sizeof(flags) + sizeof(heap) + sizeof(heap_pos); };
+	static void computeCPA( uint32_t now );
+
+	// hot state, structure of arrays
+	static unsigned int id[TARGET_MAX];
+	static float    dist[TARGET_MAX];    // km
+	static float    prox[TARGET_MAX];    // km, including altitude difference
+	static int16_t  x[TARGET_MAX];       // screen position
+	static int16_t  y[TARGET_MAX];
+	static uint32_t seen[TARGET_MAX];    // ms, esp_timer at receipt of the last PFLAA
+	static int      climb[TARGET_MAX];   // 1/100 m/s
+	static int16_t  rn[TARGET_MAX];      // m, relative position of this frame
+	static int16_t  re[TARGET_MAX];
+	static int16_t  rv[TARGET_MAX];
+	static int16_t  vn[TARGET_MAX];      // dm/s, velocity relative to the own one
+	static int16_t  ve[TARGET_MAX];
+	static uint16_t cpa[TARGET_MAX];     // m, distance at the closest point of approach
+	static uint8_t  tcpa[TARGET_MAX];    // s until then, 0 if moving apart
+	static uint16_t threat[TARGET_MAX];  // m, proximity shortened by an approach, see computeCPA(), UINT16_MAX if aged out
+	static uint8_t  flags[TARGET_MAX];
+
+private:
+	static TargetTable< uint8_t, TARGET_TABLE_SLOTS > index;   // ID -> index
+	static Target cold[TARGET_MAX];
+	static int num;
+	static uint8_t heap[TARGET_MAX];      // indices, min-heap on threat
+	static uint8_t heap_pos[TARGET_MAX];  // index -> position in heap
+	static int best;                      // best climber, -1 if none
+	static bool best_stale;               // best to be searched again
+	static int alarms;
+	static void setThreat( int i, uint16_t t );
+	static void siftUp( int p );
+	static void siftDown( int p );
+};
+
+#endif /* MAIN_TARGETSTORE_H_ */
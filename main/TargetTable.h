@@ -0,0 +1,141 @@
+/*
+ * TargetTable.h
+ *
+ * Statically sized, open addressed hash table keyed by the 24 bit FLARM ID.
+ *
+ * Linear probing, deletion by backward shift, so there are no tombstones and
+ * probe chains never degrade over a long flight. No heap is used at all.
+ * Entries move on erase: never keep a pointer to a value across an erase(),
+ * keep the ID and find() it again.
+ *
+ * Iteration by range for visits the slots in table order and must not erase.
+ * next() walks the IDs in ascending order, which stays stable while targets
+ * come and go (same order as the std::map it replaces).
+ *
+ * Kept free of ESP-IDF includes, so it can be compiled on the host too.
+ */
+
+#ifndef TARGET_TABLE_H
+#define TARGET_TABLE_H
+
+#include <cstdint>
+#include <cstddef>
+
+#ifndef TARGET_TABLE_SLOTS
+#define TARGET_TABLE_SLOTS 96   // build time capacity, holds up to 3/4 of it (72 targets)
+#endif
+
+#define NO_TARGET 0xFFFFFFFFu   // never a valid 24 bit FLARM ID
+
+template <typename Type, size_t Slots>
+class TargetTable
+{
+public:
+	struct entry_t {
+		unsigned int first;    // FLARM ID, same member names as std::pair
+		Type second;
+		bool used;
+	};
+
+	class iterator {
+	public:
+		iterator( entry_t *e, entry_t *end ) : p(e), last(end) { skip(); };
+		inline entry_t &operator*() const { return *p; };
+		inline entry_t *operator->() const { return p; };
+		inline iterator &operator++() { p++; skip(); return *this; };
+		inline bool operator!=( const iterator &o ) const { return p != o.p; };
+	private:
+		inline void skip() { while( p != last && !p->used ) p++; };
+		entry_t *p;
+		entry_t *last;
+	};
+
+	static const size_t MAX_ENTRIES = Slots*3/4;
+
+	TargetTable() : count(0) {
+		for( size_t i=0; i<Slots; i++ )
+			slot[i].used = false;
+	};
+
+	inline iterator begin() { return iterator( slot, slot+Slots ); };
+	inline iterator end() { return iterator( slot+Slots, slot+Slots ); };
+	inline size_t size() const { return count; };
+
+	Type *find( unsigned int id ) {
+		for( size_t i=home( id ); slot[i].used; i=wrap( i+1 ) ){
+			if( slot[i].first == id )
+				return &slot[i].second;
+		}
+		return nullptr;
+	};
+
+	// insert a new or overwrite an existing entry, nullptr when the table is full
+	Type *insert( unsigned int id, const Type &value ) {
+		size_t i = home( id );
+		for( ; slot[i].used; i=wrap( i+1 ) ){
+			if( slot[i].first == id ){
+				slot[i].second = value;
+				return &slot[i].second;
+			}
+		}
+		if( count >= MAX_ENTRIES )
+			return nullptr;
+		slot[i].first = id;
+		slot[i].second = value;
+		slot[i].used = true;
+		count++;
+		return &slot[i].second;
+	};
+
+	bool erase( unsigned int id ) {
+		size_t i = home( id );
+		for( ; slot[i].used; i=wrap( i+1 ) ){
+			if( slot[i].first == id )
+				break;
+		}
+		if( !slot[i].used )
+			return false;
+		// backward shift: pull every following entry of the chain that may live at i
+		for( size_t j=wrap( i+1 ); slot[j].used; j=wrap( j+1 ) ){
+			size_t k = home( slot[j].first );
+			bool movable = (i <= j) ? (k <= i || k > j) : (k <= i && k > j);
+			if( movable ){
+				slot[i].first = slot[j].first;
+				slot[i].second = slot[j].second;
+				i = j;
+			}
+		}
+		slot[i].used = false;
+		count--;
+		return true;
+	};
+
+	// smallest ID above after, NO_TARGET if there is none
+	unsigned int next( unsigned int after ) const {
+		unsigned int best = NO_TARGET;
+		for( size_t i=0; i<Slots; i++ ){
+			if( slot[i].used && slot[i].first > after && slot[i].first < best )
+				best = slot[i].first;
+		}
+		return best;
+	};
+	// smallest ID, NO_TARGET if the table is empty
+	unsigned int first() const {
+		unsigned int best = NO_TARGET;
+		for( size_t i=0; i<Slots; i++ ){
+			if( slot[i].used && slot[i].first < best )
+				best = slot[i].first;
+		}
+		return best;
+	};
+
+private:
+	// fibonacci hash of the ID, reduced to any table size by multiply and shift
+	inline static size_t home( unsigned int id ) { return (size_t)(((uint64_t)(uint32_t)(id * 0x9E3779B1u) * Slots) >> 32); };
+	inline static size_t wrap( size_t i ) { return i == Slots ? 0 : i; };
+
+	entry_t slot[Slots];
+	size_t count;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "Webserver.h"
 #include "logdef.h"
 #include "coredump_to_server.h"
+#include "Flarmnet.h"
 #include <algorithm>
 
 cWebserver* cWebserver::m_instance = nullptr;
@@ -31,6 +32,7 @@ static esp_err_t GET_backup_handler(httpd_req_t *req);
 static esp_err_t POST_restore_handler(httpd_req_t *req);
 static esp_err_t DELETE_reset_handler(httpd_req_t *req);
 static esp_err_t GET_coredump_handler(httpd_req_t *req);
+static esp_err_t POST_flarmnet_handler(httpd_req_t *req);
 
 httpd_uri_t GET_index_html = {
 	.uri = "/",
@@ -88,6 +90,13 @@ httpd_uri_t GET_coredump = {
 	.user_ctx = NULL
 };
 
+httpd_uri_t POST_flarmnet = {
+	.uri = "/flarmnet",
+	.method = HTTP_POST,
+	.handler = POST_flarmnet_handler,
+	.user_ctx = NULL
+};
+
 cWebserver& cWebserver::getInstance()
 {
     if(m_instance == nullptr)
@@ -137,6 +146,7 @@ void cWebserver::start()
 		httpd_register_uri_handler(m_httpHandle, &POST_restore);
 		httpd_register_uri_handler(m_httpHandle, &DELETE_reset);
 	    httpd_register_uri_handler(m_httpHandle, &GET_coredump);
+		httpd_register_uri_handler(m_httpHandle, &POST_flarmnet);
 	}
     else
     {
@@ -428,3 +438,77 @@ static esp_err_t GET_coredump_handler(httpd_req_t *req)
 	clear_coredump();
 	return ESP_OK;
 }
+
+// receive n bytes, retrying on socket timeouts
+static int recv_all(httpd_req_t *req, char *buf, size_t n)
+{
+    size_t got = 0;
+    while (got < n)
+    {
+        int recv_len = httpd_req_recv(req, buf + got, n - got);
+        if (recv_len == HTTPD_SOCK_ERR_TIMEOUT)
+        {
+            ESP_LOGW(FNAME, "Socket Timeout");
+            continue;
+        }
+        if (recv_len <= 0)
+        {
+            return -1;
+        }
+        got += recv_len;
+    }
+    return got;
+}
+
+// POST /flarmnet, body is flarmnet.bin from tools/fln2bin.py, e.g.
+//   curl --data-binary @flarmnet.bin http://192.168.4.1/flarmnet
+// Streamed into the flarmnet partition, header first for the size, CRC checked at the end
+static esp_err_t POST_flarmnet_handler(httpd_req_t *req)
+{
+    const size_t buff_size = 4096;
+    ESP_LOGI(FNAME, "Flarmnet upload %d bytes", req->content_len);
+
+    flarmnet_header_t header;
+    if (req->content_len < sizeof(header) || recv_all(req, (char*)&header, sizeof(header)) < 0)
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No flarmnet database");
+        return ESP_FAIL;
+    }
+    if (header.size != req->content_len || !Flarmnet::beginUpdate(header))
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid flarmnet database");
+        return ESP_FAIL;
+    }
+
+    char *buff = (char*)malloc(buff_size);
+    size_t remaining = req->content_len - sizeof(header);
+    bool ok = buff != nullptr;
+    while (ok && remaining > 0)
+    {
+        int recv_len = recv_all(req, buff, std::min(remaining, buff_size));
+        ok = recv_len > 0 && Flarmnet::writeUpdate(buff, recv_len);
+        if (ok)
+        {
+            remaining -= recv_len;
+        }
+    }
+    free(buff);
+
+    if (!ok)
+    {
+        Flarmnet::abortUpdate();
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Flarmnet upload failed");
+        return ESP_FAIL;
+    }
+    if (!Flarmnet::endUpdate())
+    {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Flarmnet CRC error");
+        return ESP_FAIL;
+    }
+
+    char res[60];
+    snprintf(res, sizeof(res), "Flarmnet %s: %d entries", Flarmnet::version(), Flarmnet::size());
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_send(req, res, strlen(res));
+    return ESP_OK;
+}
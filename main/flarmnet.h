@@ -1,8 +1,138 @@
-#include <inttypes.h>
-#include "pgmspace.h"
-
-typedef const struct s_flarmnet{
-	const uint32_t flarmID;
-	const char*     reg;
-	const char*     comp;
-} t_flarmnet;
+/*
+ * flarmnet.h
+ *
+ * Binary flarmnet database as written by tools/fln2bin.py into the flarmnet
+ * data partition, and its lookup. Used memory mapped by class Flarmnet.
+ *
+ * Layout, all offsets from the start of the partition, little endian:
+ *
+ *   flarmnet_header_t
+ *   ids      count packed 24 bit big endian IDs in ascending order (3 bytes each)
+ *   refs     count uint32_t: registration number | CN number << reg_bits
+ *   buckets  uint32_t offset into regs of every FLARMNET_BUCKET-th registration
+ *   regs     the distinct registrations, sorted and front coded: per string one
+ *            byte (length of the prefix shared with the previous string << 4 |
+ *            length of the rest), then the rest. Each bucket starts with prefix 0.
+ *   cns      the distinct CNs in FLARMNET_CN_LEN-1 byte slots, zero padded,
+ *            CN number 0 is the empty string
+ *
+ * Nearly every aircraft has its own registration, but sorted they share long
+ * prefixes (D-K..., HB-..., OE-...), and CNs repeat. An entry costs 7 bytes
+ * plus ~3 bytes of front coded registration.
+ *
+ * The CRC covers everything behind the header up to size. An update writes
+ * the header last, so an interrupted upload never leaves a valid looking
+ * database behind.
+ *
+ * Kept free of ESP-IDF includes, so it can be compiled on the host too.
+ */
+
+#ifndef FLARMNET_H
+#define FLARMNET_H
+
+#include <cstdint>
+
+#define FLARMNET_MAGIC   0x424E4C46   // "FLNB"
+#define FLARMNET_FORMAT  2
+#define FLARMNET_REG_LEN 12           // incl. terminator, longer ones are cut by the generator (max 16)
+#define FLARMNET_CN_LEN  4
+#define FLARMNET_BUCKET  16           // registrations per front coding bucket
+
+typedef struct {
+	uint32_t magic;
+	uint16_t format;
+	uint16_t header_len;   // sizeof(flarmnet_header_t)
+	uint32_t count;
+	uint32_t ids;
+	uint32_t refs;
+	uint32_t buckets;
+	uint32_t regs;
+	uint32_t cns;
+	uint32_t nregs;        // distinct registrations
+	uint32_t ncns;         // distinct CNs, including the empty one
+	uint32_t reg_bits;     // bits of the registration number in a refs entry
+	uint32_t size;         // total bytes including the header
+	uint32_t crc;          // CRC32 (zlib) over header_len..size
+	char version[8];       // DDMMYY, zero terminated
+} flarmnet_header_t;
+
+inline uint32_t flarmnetID( const uint8_t *ids, int i ) {
+	const uint8_t *p = ids + 3*i;
+	return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+}
+
+// Index of id in the packed ascending ID array, -1 if not present.
+// Binary search, ~15 probes for 40000 entries. Interpolation search was
+// measured too (tools/flarmnet_bench.cpp), the IDs come in dense blocks
+// (FLARM DDxxxx, ICAO ranges per country) where it saves two probes at best
+// for a 64 bit division per probe, which the ESP32-S2 does in software.
+inline int flarmnetFind( const uint8_t *ids, int n, uint32_t id ) {
+	int lo = 0;
+	int hi = n-1;
+	while( lo <= hi ){
+		int mid = lo + (hi-lo)/2;
+		uint32_t m = flarmnetID( ids, mid );
+		if( m == id )
+			return mid;
+		if( m < id )
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -1;
+}
+
+// Sanity check of a header against the bytes available, before anything is mapped or written
+inline bool flarmnetHeaderValid( const flarmnet_header_t &h, uint32_t avail ) {
+	if( h.magic != FLARMNET_MAGIC || h.format != FLARMNET_FORMAT || h.header_len != sizeof(flarmnet_header_t) )
+		return false;
+	if( h.size > avail || h.ids < h.header_len || h.count > (h.size - h.ids) / 7 || h.nregs > h.size || h.reg_bits > 31 )
+		return false;
+	uint32_t nbuckets = (h.nregs + FLARMNET_BUCKET - 1) / FLARMNET_BUCKET;
+	return h.refs >= h.ids + 3*h.count && h.buckets >= h.refs + 4*h.count && h.regs >= h.buckets + 4*nbuckets &&
+			h.cns >= h.regs && h.ncns <= (h.size - h.cns) / (FLARMNET_CN_LEN-1);
+}
+
+inline uint32_t flarmnetLE32( const uint8_t *p ) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Decode the strings of entry i into reg (FLARMNET_REG_LEN) and cn (FLARMNET_CN_LEN),
+// false with both empty if the entry is malformed
+inline bool flarmnetStrings( const uint8_t *base, const flarmnet_header_t &h, int i, char *reg, char *cn ) {
+	uint32_t ref = flarmnetLE32( base + h.refs + 4*i );
+	uint32_t r = ref & ((1u << h.reg_bits) - 1);
+	uint32_t c = ref >> h.reg_bits;
+	reg[0] = '\0';
+	cn[0] = '\0';
+	if( r >= h.nregs || c >= h.ncns )
+		return false;
+	// walk the bucket up to r, each string overwrites the tail of the previous one
+	uint32_t off = h.regs + flarmnetLE32( base + h.buckets + 4*(r / FLARMNET_BUCKET) );
+	for( uint32_t k = r % FLARMNET_BUCKET + 1; k; k-- ){
+		if( off >= h.cns ){
+			reg[0] = '\0';
+			return false;
+		}
+		int prefix = base[off] >> 4;
+		int rest = base[off] & 0xF;
+		off++;
+		if( prefix + rest >= FLARMNET_REG_LEN || off + rest > h.cns ){
+			reg[0] = '\0';   // not the partly decoded string before
+			return false;
+		}
+		for( int n=0; n<rest; n++ )
+			reg[prefix+n] = base[off++];
+		reg[prefix+rest] = '\0';
+	}
+	const uint8_t *p = base + h.cns + (FLARMNET_CN_LEN-1)*c;
+	int n = 0;
+	while( n < FLARMNET_CN_LEN-1 && p[n] ){
+		cn[n] = p[n];
+		n++;
+	}
+	cn[n] = '\0';
+	return true;
+}
+
+#endif
@@ -23,7 +23,7 @@
 #include "OTA.h"
 #include "Version.h"
 #include "Colors.h"
-#include "flarmnetdata.h"
+#include "Flarmnet.h"
 #include "TargetManager.h"
 #include "Switch.h"
 #include "SetupMenu.h"
@@ -195,6 +195,7 @@ extern "C" void app_main(void)
     Switch::startTask();
 
     egl->clearScreen();
+    Flarmnet::begin();
     Flarm::begin();
     Serial::begin();
     TM.begin();
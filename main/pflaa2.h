@@ -2103,4 +2103,4 @@ const char *pflaa2[] = {
 		"$PFLAA,0,-5,-13,-9,2,DDA3E7,0,,0,-0.1,1*64\n"
 };
 
-#define NUM_PFLAA2_SIM (sizeof(pflaa2)/4)
+#define NUM_PFLAA2_SIM (sizeof(pflaa2)/sizeof(pflaa2[0]))
@@ -17,6 +17,7 @@
 #include <cmath>
 #include "Units.h"
 #include "vector.h"
+#include "FixMath.h"
 #include "logdef.h"
 
 Vector::Vector() :
@@ -124,9 +125,10 @@ float Vector::polar(float y, float x)
 	return angle;
 }
 
+// binary angles wrap around by themselves, no normalize loops, resolution 0.0055 deg
 float Vector::angleDiffDeg(float ang1, float ang2)
 {
-	return( normalizeDeg180( normalizeDeg180(ang1) - normalizeDeg180( ang2 ) ) );
+	return( bangleToDeg( bangleFromDeg(ang1) - bangleFromDeg(ang2) ) );
 }
 
 float Vector::angleDiff(float ang1, float ang2)
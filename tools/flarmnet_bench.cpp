@@ -0,0 +1,202 @@
+/*
+ * flarmnet_bench.cpp - host side benchmark of the flarmnet ID lookup
+ *
+ * Looks up every ID of the database plus the same number of absent IDs with
+ * the legacy full linear scan over {id, reg, cn} structs, plain interpolation,
+ * interpolation alternating with bisection and the binary search of flarmnet.h
+ * over the packed 24 bit ID array, and the binary search plus decoding of the
+ * front coded strings.
+ * Prints CPU cycles (TSC on x86 hosts) and probes per lookup, and the bytes
+ * of the ID index.
+ *
+ * Uses the binary database written by tools/fln2bin.py (default flarmnet.bin,
+ * checked like Flarmnet::open() does on target). If there is none, a synthetic
+ * database with the same clustering (FLARM DDxxxx/DFxxxx blocks, ICAO country
+ * ranges) is used instead.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -std=c++17 -Imain tools/flarmnet_bench.cpp -o flarmnet_bench && ./flarmnet_bench [flarmnet.bin]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+
+#include "flarmnet.h"
+
+typedef struct {
+	unsigned int id;
+	const char *reg;
+	const char *cn;
+} legacy_entry_t;
+
+typedef struct {
+	char reg[FLARMNET_REG_LEN];
+	char cn[FLARMNET_CN_LEN];
+} strings_t;
+
+static int probes;
+
+static int legacyFind( const std::vector<legacy_entry_t> &db, uint32_t id ){
+	int found = -1;
+	for( size_t i=0; i<db.size(); i++ ){   // as before: no break
+		if( id == db[i].id )
+			found = i;
+	}
+	probes += db.size();
+	return found;
+}
+
+// flarmnetFind() with a probe counter
+static int binaryFind( const uint8_t *ids, int n, uint32_t id ){
+	int lo = 0, hi = n-1;
+	while( lo <= hi ){
+		int mid = lo + (hi-lo)/2;
+		uint32_t m = flarmnetID( ids, mid );
+		probes++;
+		if( m == id ) return mid;
+		if( m < id ) lo = mid+1; else hi = mid-1;
+	}
+	return -1;
+}
+
+// interpolation search, alternate: every other probe bisects
+static int interpolationFind( const uint8_t *ids, int n, uint32_t id, bool alternate ){
+	int lo = 0, hi = n-1;
+	bool interpolate = true;
+	while( lo <= hi ){
+		uint32_t a = flarmnetID( ids, lo ), b = flarmnetID( ids, hi );
+		if( id < a || id > b ) return -1;
+		int mid = lo + (hi-lo)/2;
+		if( interpolate && b > a )
+			mid = lo + (int)((uint64_t)(id - a) * (uint32_t)(hi - lo) / (b - a));
+		if( alternate )
+			interpolate = !interpolate;
+		uint32_t m = flarmnetID( ids, mid );
+		probes++;
+		if( m == id ) return mid;
+		if( m < id ) lo = mid+1; else hi = mid-1;
+	}
+	return -1;
+}
+
+// zlib CRC32 as esp_rom_crc32_le( 0, ... )
+static uint32_t crc32( const uint8_t *p, size_t n ){
+	uint32_t c = 0xFFFFFFFF;
+	while( n-- ){
+		c ^= *p++;
+		for( int k=0; k<8; k++ )
+			c = (c >> 1) ^ (0xEDB88320 & -(c & 1));
+	}
+	return ~c;
+}
+
+static bool loadBin( const char *file, std::vector<uint8_t> &bin ){
+	FILE *f = fopen( file, "rb" );
+	if( !f )
+		return false;
+	int c;
+	while( (c = fgetc( f )) != EOF )
+		bin.push_back( c );
+	fclose( f );
+	flarmnet_header_t h;
+	if( bin.size() < sizeof(h) )
+		return false;
+	memcpy( &h, bin.data(), sizeof(h) );
+	if( !flarmnetHeaderValid( h, bin.size() ) || crc32( bin.data() + h.header_len, h.size - h.header_len ) != h.crc ){
+		printf( "%s: invalid flarmnet database\n", file );
+		return false;
+	}
+	return true;
+}
+
+template <typename F>
+static void run( const char *name, const std::vector<uint32_t> &keys, int expect_hits, F find ){
+	probes = 0;
+	int hits = 0;
+	unsigned long long start = CYCLES();
+	for( uint32_t k : keys )
+		hits += find( k ) >= 0;
+	unsigned long long c = (CYCLES() - start) / keys.size();
+	printf( "%-14s %10llu cycles %8.1f probes/lookup %s\n", name, c, probes/(double)keys.size(),
+			hits == expect_hits ? "" : "HIT MISMATCH" );
+}
+
+int main( int argc, char **argv ){
+	const char *file = argc > 1 ? argv[1] : "flarmnet.bin";
+	std::vector<uint8_t> packed;
+	std::vector<legacy_entry_t> legacy;
+	std::vector<uint8_t> bin;
+	std::vector<strings_t> strings;
+	if( loadBin( file, bin ) ){
+		flarmnet_header_t h;
+		memcpy( &h, bin.data(), sizeof(h) );
+		packed.assign( bin.data() + h.ids, bin.data() + h.ids + 3*h.count );
+		strings.resize( h.count );
+		for( int i=0; i<(int)h.count; i++ ){
+			flarmnetStrings( bin.data(), h, i, strings[i].reg, strings[i].cn );
+			legacy.push_back( { flarmnetID( packed.data(), i ), strings[i].reg, strings[i].cn } );
+		}
+		printf( "%s %s: %d entries, %d bytes (%d registrations in %d bytes, %d CNs)\n", file, h.version, h.count, h.size,
+				h.nregs, h.cns - h.regs, h.ncns );
+	}
+	else {
+		std::vector<uint32_t> ids;
+		srand( 7 );
+		const uint32_t flarm[] = { 0xDD0000, 0xDF0000, 0xD00000 };
+		const uint32_t icao[] = { 0x3C0000, 0x3D0000, 0x3E0000, 0x4B0000, 0x440000, 0x480000, 0xA00000 };
+		for( int i=0; i<22000; i++ ) ids.push_back( flarm[rand()%3] + rand()%0x10000 );
+		for( int i=0; i<14000; i++ ) ids.push_back( icao[rand()%7] + rand()%0x40000 );
+		for( int i=0; i<2000; i++ ) ids.push_back( rand() & 0xFFFFFF );
+		std::sort( ids.begin(), ids.end() );
+		ids.erase( std::unique( ids.begin(), ids.end() ), ids.end() );
+		for( uint32_t id : ids ){
+			packed.push_back( id >> 16 ); packed.push_back( id >> 8 ); packed.push_back( id );
+			legacy.push_back( { id, "D-0000", "" } );
+		}
+		printf( "synthetic database (run tools/generate_flarmnet.sh for the real one): %d entries\n", (int)ids.size() );
+	}
+	int n = legacy.size();
+	const uint8_t *p = packed.data();
+	printf( "ID index: %d bytes packed, %d bytes as {id, reg, cn} structs (32 bit)\n\n", 3*n, 12*n );
+
+	std::vector<uint32_t> keys;
+	for( auto &e : legacy ) keys.push_back( e.id );
+	std::vector<uint32_t> miss;
+	srand( 11 );
+	while( (int)miss.size() < n ){
+		uint32_t k = legacy[rand()%n].id + 1 + rand()%16;   // near existing IDs, the hard case
+		if( flarmnetFind( p, n, k ) < 0 ) miss.push_back( k );
+	}
+	std::vector<uint32_t> legacy_keys( keys.begin(), keys.begin() + std::min( n, 500 ) );
+
+	printf( "present IDs\n" );
+	run( "linear", legacy_keys, legacy_keys.size(), [&]( uint32_t k ){ return legacyFind( legacy, k ); } );
+	run( "interpolation", keys, n, [&]( uint32_t k ){ return interpolationFind( p, n, k, false ); } );
+	run( "interp+bisect", keys, n, [&]( uint32_t k ){ return interpolationFind( p, n, k, true ); } );
+	run( "flarmnetFind", keys, n, [&]( uint32_t k ){ return binaryFind( p, n, k ); } );
+	printf( "absent IDs\n" );
+	run( "interpolation", miss, 0, [&]( uint32_t k ){ return interpolationFind( p, n, k, false ); } );
+	run( "interp+bisect", miss, 0, [&]( uint32_t k ){ return interpolationFind( p, n, k, true ); } );
+	run( "flarmnetFind", miss, 0, [&]( uint32_t k ){ return binaryFind( p, n, k ); } );
+	if( !bin.empty() ){
+		flarmnet_header_t h;
+		memcpy( &h, bin.data(), sizeof(h) );
+		char reg[FLARMNET_REG_LEN], cn[FLARMNET_CN_LEN];
+		printf( "find + decode\n" );
+		run( "flarmnetFind", keys, n, [&]( uint32_t k ){
+			int i = binaryFind( p, n, k );
+			flarmnetStrings( bin.data(), h, i, reg, cn );
+			return reg[0] ? i : -1;
+		} );
+	}
+	return 0;
+}
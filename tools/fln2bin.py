@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import csv
+import struct
+import sys
+import zlib
+import requests
+import re
+
+import datetime
+
+# Binaerformat der flarmnet Partition, Layout siehe main/flarmnet.h
+MAGIC = 0x424E4C46   # "FLNB"
+FORMAT = 2
+HEADER = struct.Struct("<IHHIIIIIIIIIII8s")
+REG_LEN = 12 - 1     # FLARMNET_REG_LEN ohne Terminator
+CN_LEN = 4 - 1       # FLARMNET_CN_LEN ohne Terminator
+BUCKET = 16          # FLARMNET_BUCKET
+PARTITION_SIZE = 0xE0000
+
+URL_OGN = "http://ddb.glidernet.org/download"
+URL_FLARMNET = "https://www.flarmnet.org/files/ddb.csv"
+
+
+# Get current date
+today = datetime.date.today()
+
+# Format as DDMMYY
+version_str = today.strftime("%d%m%y")
+
+def download_file(url, local_file):
+    r = requests.get(url)
+    r.raise_for_status()
+    with open(local_file, "wb") as f:
+        f.write(r.content)
+    return local_file
+
+def clean_field(field):
+    """Entfernt Quotes, Leerzeichen und prüft Inhalt"""
+    return field.strip().strip("'").strip('"')
+
+def valid_entry(reg, cn):
+    """Eintrag nur gültig, wenn REG mindestens 4 alphanumerische Zeichen oder CN nicht leer"""
+    if cn:
+        return True
+    alpha_count = len(re.findall(r'[A-Za-z0-9]', reg))
+    return alpha_count >= 4
+
+def load_csv_file(file):
+    """Lädt CSV-Datei OGN oder Flarmnet robust"""
+    data = {}
+    with open(file, "r", encoding="latin1") as f:
+        reader = csv.reader(f)
+        for row in reader:
+            if not row or row[0].startswith("#"):
+                continue
+            row = [clean_field(c) for c in row]
+            if len(row) < 5:
+                continue
+            try:
+                fid = int(row[1], 16)   # Schreibweise der Hex ID vereinheitlichen
+            except ValueError:
+                continue
+            if fid > 0xFFFFFF:    # FLARM IDs sind 24 Bit
+                continue
+            reg = row[3]
+            cn  = row[4]
+            if valid_entry(reg, cn):
+                data[fid] = {"id": fid, "reg": reg, "cn": cn}
+    return data
+
+def main():
+    ogn_file = "iglide_dec.fln"
+    flarm_file = "ddb.csv"
+    download_file(URL_OGN, ogn_file)
+    download_file(URL_FLARMNET, flarm_file)
+
+    ogn_data = load_csv_file(ogn_file)
+    flarm_data = load_csv_file(flarm_file)
+
+    # Ergänze Flarmnet nur, wenn ID fehlt
+    for fid, entry in flarm_data.items():
+        if fid not in ogn_data:
+            ogn_data[fid] = entry
+
+    write_bin(ogn_data, sys.argv[1] if len(sys.argv) > 1 else "flarmnet.bin")
+
+def front_code(regs):
+    """Sortierte Kennzeichen front-kodiert: je String ein Byte (gemeinsamer Praefix << 4 | Restlaenge)
+    und der Rest, jeder Bucket beginnt mit Praefix 0. Liefert Bucket Offsets und Pool"""
+    buckets = bytearray()
+    pool = bytearray()
+    prev = b""
+    for i, reg in enumerate(regs):
+        if i % BUCKET == 0:
+            buckets += struct.pack("<I", len(pool))
+            prev = b""
+        prefix = 0
+        while prefix < min(len(prev), len(reg)) and prev[prefix] == reg[prefix]:
+            prefix += 1
+        pool.append((prefix << 4) | (len(reg) - prefix))
+        pool += reg[prefix:]
+        prev = reg
+    return buckets, pool
+
+def write_bin(data, out_file):
+    sorted_keys = sorted(data.keys())
+    reg_of = {fid: data[fid]["reg"].encode("latin1")[:REG_LEN] for fid in sorted_keys}
+    cn_of = {fid: data[fid]["cn"].encode("latin1")[:CN_LEN] for fid in sorted_keys}
+
+    regs = sorted(set(reg_of.values()))
+    reg_num = {reg: i for i, reg in enumerate(regs)}
+    buckets, reg_pool = front_code(regs)
+
+    cn_list = [b""] + sorted(set(cn_of.values()) - {b""})
+    cn_num = {cn: i for i, cn in enumerate(cn_list)}
+    cns = b"".join(cn.ljust(CN_LEN, b"\0") for cn in cn_list)
+
+    # Registrations- und CN-Nummer teilen sich 32 Bit
+    reg_bits = max(1, (len(regs) - 1).bit_length())
+    if reg_bits + max(1, (len(cn_list) - 1).bit_length()) > 32:
+        sys.exit(f"{len(regs)} registrations and {len(cn_list)} CNs do not fit into 32 bit refs")
+
+    ids = bytearray()
+    refs = bytearray()
+    for fid in sorted_keys:
+        ids += struct.pack(">I", fid)[1:]
+        refs += struct.pack("<I", reg_num[reg_of[fid]] | (cn_num[cn_of[fid]] << reg_bits))
+
+    body = ids + refs + buckets + reg_pool + cns
+    ids_off = HEADER.size
+    refs_off = ids_off + len(ids)
+    buckets_off = refs_off + len(refs)
+    regs_off = buckets_off + len(buckets)
+    cns_off = regs_off + len(reg_pool)
+    size = HEADER.size + len(body)
+    if size > PARTITION_SIZE:
+        sys.exit(f"flarmnet database {size} bytes exceeds the partition ({PARTITION_SIZE} bytes)")
+    header = HEADER.pack(MAGIC, FORMAT, HEADER.size, len(sorted_keys), ids_off, refs_off, buckets_off,
+                         regs_off, cns_off, len(regs), len(cn_list), reg_bits, size, zlib.crc32(body),
+                         version_str.encode())
+    with open(out_file, "wb") as f:
+        f.write(header + body)
+    print(f"{out_file}: {len(sorted_keys)} entries, {len(regs)} registrations ({len(reg_pool)} bytes), "
+          f"{len(cn_list)} CNs ({len(cns)} bytes), {size} bytes, version {version_str}")
+
+if __name__ == "__main__":
+    main()
+
@@ -0,0 +1,273 @@
+/*
+ * frame_time.cpp - host side estimate of the frame time with the blocking and
+ * the DMA HAL of the ILI9341
+ *
+ * Renders a scripted scene through the Compositor and the ILI9341 driver,
+ * eight targets circling the own airplane with the info fields, as
+ * tools/spi_replay.cpp, and once a screen cleared and filled with menu lines.
+ * A HAL stand-in records every send with its bytes and the CPU time spent
+ * rendering since the last one, the host time scaled by the factor given.
+ * The trace is then timed twice:
+ *
+ *   blocking: esp32_ili9341, CPU and wire in turn, T_TRANSFER per esend()
+ *             besides its bytes, as in tools/span_bench.cpp
+ *   DMA:      esp32_ili9341_dma, CPU and wire in parallel. Each send costs
+ *             the CPU T_QUEUE per transaction plus copying into the line
+ *             buffer, and waits for a free transaction or line buffer as the
+ *             HAL does. The wire idles T_GAP between transactions.
+ *
+ * For the DMA HAL the CPU time, until the renderer could go on, and the time
+ * until the last byte is on the wire are given. T_TRANSFER, T_QUEUE, T_GAP,
+ * COPY_RATE and the scale are estimates for the ESP32-S2 at 240 MHz; the
+ * "Frame" log line of TargetManager gives the compose cycles on target with
+ * either HAL (EGL_SPI_DMA in AdaptUGC.cpp).
+ *
+ * Build and run from the repository root, optionally with the scale:
+ *   E=components/eglib; gcc -O2 -c -Itools/host -I$E -I$E/eglib -I$E/eglib/hal/four_wire_spi/esp32 \
+ *     $E/eglib.c $E/eglib/display.c $E/eglib/drawing.c $E/eglib/hal.c $E/eglib/display/ili9341.c \
+ *     $E/eglib/display/tile.c $E/eglib/hal/four_wire_spi/none.c \
+ *     $E/eglib/drawing/fonts/adobe/helvetica_bold.c $E/eglib/drawing/fonts/adobe/new_century_schoolbook_roman.c && \
+ *   g++ -O2 -std=c++17 -Itools/host -I$E -I$E/eglib -Imain tools/frame_time.cpp main/Compositor.cpp *.o -lm -o frame_time && \
+ *   rm *.o && ./frame_time 30
+ *
+ * Add -DEGLIB_RGB565=1 to both compile lines for the RGB565 pixel format,
+ * -DDISPLAY_W=240 -DDISPLAY_H=320 for the 2.4 inch display.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "Compositor.h"
+extern "C" {
+#include <eglib/display/ili9341.h>
+#include <eglib/drawing/fonts.h>
+}
+
+#ifndef DISPLAY_W
+#define DISPLAY_W  320
+#define DISPLAY_H  172
+#endif
+#define TARGETS    8
+#define FRAMES     600
+#define SIDE       18
+
+#define F_SPI      (13111111*3)   // Hz, as AdaptUGC
+#define T_TRANSFER 2.0            // us per esend() of the blocking HAL
+#define T_QUEUE    4.0            // us CPU per transaction, spi_device_queue_trans() and its result
+#define T_GAP      3.0            // us between transactions on the wire, interrupt and pre_cb
+#define COPY_RATE  100.0          // bytes/us into the line buffer
+#define LINE       (320*3*8)      // ESP32_ILI9341_DMA_LINE
+#define QUEUE      16             // ESP32_ILI9341_DMA_QUEUE
+
+static const color_t BLACK = { 0, 0, 0 }, WHITE = { 255, 255, 255 }, GREEN = { 0, 255, 0 }, BLUE = { 0, 0, 255 };
+static const struct font_t *font_big = &font_Adobe_HelveticaBold_24px;
+static const struct font_t *font_unit = &font_Adobe_HelveticaBold_18px;
+static const struct font_t *font_ncen = &font_Adobe_NewCenturySchoolbookRoman_20px;
+
+//
+// HAL recording the sends
+//
+
+typedef std::chrono::steady_clock Clock;
+
+struct Send {
+	double cpu;       // us of host CPU before it
+	uint32_t bytes;
+};
+
+static std::vector<Send> trace;
+static Clock::time_point last;
+
+static void start(){
+	trace.clear();
+	last = Clock::now();
+}
+
+extern "C" {
+static void hal_init( eglib_t * ){}
+static void hal_sleep( eglib_t * ){}
+static void hal_delay_ns( eglib_t *, uint32_t ){}
+static void hal_set_reset( eglib_t *, bool ){}
+static bool hal_get_busy( eglib_t * ){ return false; }
+static void hal_comm( eglib_t * ){}
+static void hal_send( eglib_t *, enum hal_dc_t, uint8_t *, uint32_t length ){
+	Clock::time_point now = Clock::now();
+	trace.push_back( { std::chrono::duration<double, std::micro>( now - last ).count(), length } );
+	last = Clock::now();
+}
+}
+static const hal_t recording = { hal_init, hal_sleep, hal_sleep, hal_delay_ns, hal_set_reset, hal_get_busy, hal_comm, hal_send, hal_comm };
+
+// CPU time after the last send
+static double tail(){
+	return std::chrono::duration<double, std::micro>( Clock::now() - last ).count();
+}
+
+//
+// Timing of a trace, in us
+//
+
+static inline double wire( uint32_t bytes ){
+	return bytes * 8e6 / F_SPI;
+}
+
+static double blocking( double scale, double end ){
+	double t = 0;
+	for( const Send &s : trace )
+		t += s.cpu*scale + T_TRANSFER + wire( s.bytes );
+	return t + end*scale;
+}
+
+struct Dma {
+	double cpu = 0, bus = 0;
+	double slot[QUEUE] = {};     // a transaction went out
+	double line_free[2] = {};    // the last transaction of a line buffer went out
+	int cur = 0;
+	uint32_t fill = 0, n = 0;
+
+	double queue( uint32_t bytes ){
+		double &s = slot[n++ % QUEUE];
+		cpu = std::max( cpu, s ) + T_QUEUE;
+		bus = std::max( bus, cpu ) + T_GAP + wire( bytes );
+		return s = bus;
+	}
+	void send( uint32_t bytes ){
+		if( bytes <= 4 ){
+			queue( bytes );
+			return;
+		}
+		while( bytes ){
+			uint32_t c = std::min( bytes, (uint32_t)LINE );
+			if( fill + c > LINE ){
+				cur = !cur;
+				cpu = std::max( cpu, line_free[cur] );
+				fill = 0;
+			}
+			cpu += c / COPY_RATE;
+			line_free[cur] = queue( c );
+			fill += (c + 3) & ~3;
+			bytes -= c;
+		}
+	}
+};
+
+static void dma( double scale, double end, double &cpu, double &done ){
+	Dma d;
+	for( const Send &s : trace ){
+		d.cpu += s.cpu*scale;
+		d.send( s.bytes );
+	}
+	cpu = d.cpu + end*scale;
+	done = std::max( cpu, d.bus );
+}
+
+//
+// Scenario, as tools/spi_replay.cpp
+//
+
+static void radar( int f ){
+	int x = DISPLAY_W/2, y = DISPLAY_H/2;
+	Compositor::tetragon( x-15, y-1, x-15, y+1, x+15, y+1, x+15, y-1, WHITE );
+	Compositor::tetragon( x-1, y+10, x-1, y-6, x+1, y-6, x+1, y+10, WHITE );
+	Compositor::tetragon( x-4, y+10, x-4, y+9, x+4, y+9, x+4, y+10, WHITE );
+	Compositor::text( x-5, y-19, font_ncen, FONT_MIDDLE, GREEN, "N" );
+	Compositor::circle( x, y, 25, GREEN );
+	for( int i=0; i<TARGETS; i++ ){
+		float r = 25 + 9*i;
+		float a = 0.7f*i + f*(0.004f + 0.002f*(i%3))*((i&1) ? -1 : 1);
+		float h = a + ((i&1) ? -M_PI/2 : M_PI/2);
+		int tx = x + lrintf( 1.6f*r*sinf( a ) );
+		int ty = y - lrintf( 0.8f*r*cosf( a ) );
+		float axt = tx - SIDE/4.0f*sinf( h ), ayt = ty + SIDE/4.0f*cosf( h );
+		float rad = h - M_PI/2;
+		Compositor::triangle( lrintf( axt + SIDE*cosf( rad ) ), lrintf( ayt + SIDE*sinf( rad ) ),
+				lrintf( axt + SIDE/2.0f*cosf( rad + 2*M_PI/3 ) ), lrintf( ayt + SIDE/2.0f*sinf( rad + 2*M_PI/3 ) ),
+				lrintf( axt + SIDE/2.0f*cosf( rad - 2*M_PI/3 ) ), lrintf( ayt + SIDE/2.0f*sinf( rad - 2*M_PI/3 ) ), GREEN );
+		if( i == 3 ){
+			char climb[8];
+			snprintf( climb, sizeof(climb), "%d", 2 + (f/50)%3 );
+			Compositor::text( tx-4, ty-SIDE, font_ncen, FONT_MIDDLE, GREEN, climb );
+		}
+		if( i == 0 )
+			Compositor::circle( tx, ty, (SIDE*3+2)/4, GREEN );
+	}
+	char dist[16], alt[16], var[16];
+	snprintf( dist, sizeof(dist), "%.2f", 0.40 + 0.002*(f%100) );
+	snprintf( alt, sizeof(alt), "+%d", 50 + f/25 );
+	snprintf( var, sizeof(var), "%+.1f", 1.0 + 0.1*((f/10)%10) );
+	Compositor::text( DISPLAY_W-70, 30, font_big, FONT_MIDDLE, WHITE, dist );
+	Compositor::text( DISPLAY_W-120, DISPLAY_H-7, font_big, FONT_MIDDLE, WHITE, "D-1234 XY" );
+	Compositor::text( 5, DISPLAY_H-7, font_big, FONT_MIDDLE, WHITE, alt );
+	Compositor::text( 5, 30, font_big, FONT_MIDDLE, WHITE, var );
+	Compositor::text( DISPLAY_W-25, DISPLAY_H-37, font_unit, FONT_MIDDLE, BLUE, "ID" );
+	Compositor::text( DISPLAY_W-60, 50, font_unit, FONT_MIDDLE, BLUE, "Dis km" );
+	Compositor::text( 5, 50, font_unit, FONT_MIDDLE, BLUE, "Var m/s" );
+	Compositor::text( 5, DISPLAY_H-37, font_unit, FONT_MIDDLE, BLUE, "Alt m" );
+}
+
+static void menu( eglib_t *e ){
+	eglib_SetIndexColor( e, 0, 0, 0, 0 );
+	eglib_ClearScreen( e );
+	eglib_SetIndexColor( e, 0, 255, 255, 255 );
+	eglib_SetFont( e, font_unit );
+	for( int i=0; i<7; i++ )
+		eglib_DrawText( e, 10, 25 + 22*i, "Setup Menu Entry" );
+}
+
+static ili9341_config_t config = {
+	.width = DISPLAY_W,
+	.height = DISPLAY_W,
+	.color = EGLIB_RGB565 ? ILI9341_COLOR_16_BIT : ILI9341_COLOR_18_BIT,
+	.page_address = ILI9341_PAGE_ADDRESS_TOP_TO_BOTTOM,
+	.colum_address = ILI9341_COLUMN_ADDRESS_RIGHT_TO_LEFT,
+	.page_column_order = ILI9341_PAGE_COLUMN_ORDER_REVERSE,
+	.vertical_refresh = ILI9341_VERTICAL_REFRESH_TOP_TO_BOTTOM,
+	.horizontal_refresh = ILI9341_HORIZONTAL_REFRESH_RIGHT_TO_LEFT,
+};
+
+struct Stat {
+	double sum = 0, max = 0;
+	void add( double v ){ sum += v; max = std::max( max, v ); }
+};
+
+int main( int argc, char **argv ){
+	double scale = argc > 1 ? atof( argv[1] ) : 30;
+	eglib_t e;
+	eglib_Init( &e, &recording, nullptr, &ili9341, &config );
+	eglib_setClipRange( &e, 0, 0, DISPLAY_W, DISPLAY_H );
+	eglib_setFontOrigin( &e, FONT_MIDDLE );
+	Compositor::begin( &e, DISPLAY_W, DISPLAY_H, BLACK );
+
+	printf( "CPU time of the host * %.0f, SPI at %.1f MHz\n", scale, F_SPI/1e6 );
+	printf( "%-22s %10s %10s %10s %10s\n", "us", "blocking", "DMA cpu", "DMA wire", "sends" );
+	Stat b, c, w, n;
+	for( int f=0; f<FRAMES; f++ ){
+		start();
+		Compositor::beginFrame();
+		radar( f );
+		Compositor::endFrame();
+		double end = tail(), cpu, done;
+		dma( scale, end, cpu, done );
+		b.add( blocking( scale, end ) );
+		c.add( cpu );
+		w.add( done );
+		n.add( trace.size() );
+		if( !f ){
+			printf( "%-22s %10.0f %10.0f %10.0f %10zu\n", "first radar frame", b.sum, c.sum, w.sum, trace.size() );
+			b = c = w = n = Stat();
+		}
+	}
+	printf( "%-22s %10.0f %10.0f %10.0f %10.0f\n", "radar frame, mean", b.sum/(FRAMES-1), c.sum/(FRAMES-1), w.sum/(FRAMES-1), n.sum/(FRAMES-1) );
+	printf( "%-22s %10.0f %10.0f %10.0f %10.0f\n", "radar frame, max", b.max, c.max, w.max, n.max );
+
+	start();
+	menu( &e );
+	double end = tail(), cpu, done;
+	dma( scale, end, cpu, done );
+	printf( "%-22s %10.0f %10.0f %10.0f %10zu\n", "menu page", blocking( scale, end ), cpu, done, trace.size() );
+	return 0;
+}
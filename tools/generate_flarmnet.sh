@@ -1 +1,8 @@
-python fln2head.py >../main/flarmnetdata.h
+python fln2bin.py ../flarmnet.bin
+# "idf.py flash" (../flash) and ../flash-bin write it together with the app.
+# Units updated by OTA from a firmware without the flarmnet partition must be
+# flashed over USB once, OTA does not rewrite the partition table.
+# Only the flarmnet partition over USB:
+#   parttool.py write_partition --partition-name=flarmnet --input=../flarmnet.bin
+# or upload over Wi-Fi:
+#   curl --data-binary @../flarmnet.bin http://192.168.4.1/flarmnet
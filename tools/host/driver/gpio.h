@@ -0,0 +1,8 @@
+/*
+ * gpio.h - host stand-in for the ESP-IDF header, for the tools that
+ * compile eglib on the host
+ */
+
+#pragma once
+
+typedef int gpio_num_t;
@@ -0,0 +1,12 @@
+/*
+ * esp_log.h - host stand-in for the ESP-IDF header, for the tools that
+ * compile eglib on the host
+ */
+
+#pragma once
+#include <stdio.h>
+
+#define ESP_LOGE( tag, fmt, ... ) fprintf( stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__ )
+#define ESP_LOGW( tag, fmt, ... ) fprintf( stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__ )
+#define ESP_LOGI( tag, fmt, ... ) do {} while( 0 )
+#define ESP_LOGD( tag, fmt, ... ) do {} while( 0 )
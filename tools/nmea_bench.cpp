@@ -0,0 +1,244 @@
+/*
+ * nmea_bench.cpp - host side benchmark of the NMEA ingest path
+ *
+ * Replays the PFLAA sentences of main/pflaa2.h through the legacy
+ * istringstream/stoi parser and through the in place NMEAReader,
+ * prints sentences per second for both and checks that the results match.
+ * Then replays the whole pflaa2.h stream (PFLAA, PFLAU, GPRMC, GPGGA) byte by
+ * byte through the legacy framer, per parser checksum and float/sscanf
+ * decoding and through NMEAFramer plus the fixed point NMEAReader decoding
+ * and prints CPU cycles per sentence (TSC on x86 hosts).
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -std=c++17 -Imain tools/nmea_bench.cpp -o nmea_bench && ./nmea_bench
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+#include "NMEA.h"
+#include "pflaa2.h"
+
+#define ROUNDS 2000
+
+// float layout of nmea_pflaa_s before the fixed point conversion
+typedef struct {
+	int alarmLevel, relNorth, relEast, relVertical, idType;
+	unsigned int ID;
+	int track;
+	float turnRate, groundSpeed, climbRate;
+	char acftType[3];
+} legacy_pflaa_s;
+
+// reference: parser as it was used before NMEAReader
+static void legacyPFLAA( const char *pflaa, legacy_pflaa_s &PFLAA ){
+	std::istringstream ss(pflaa);
+	std::string token;
+	std::getline(ss, token, ',');
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.alarmLevel = std::stoi(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.relNorth = std::stoi(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.relEast = std::stoi(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.relVertical = std::stoi(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.idType = std::stoi(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) sscanf(token.c_str(),"%06X", &PFLAA.ID );
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.track = std::stoi(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.turnRate = std::stof(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.groundSpeed = std::stof(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) PFLAA.climbRate = std::stof(token);
+	std::getline(ss, token, ',');
+	if( !token.empty() ) sscanf(token.c_str(), "%2s", PFLAA.acftType);
+}
+
+static int centi( float v ){ return (int)(v*NMEA_CENTI + (v < 0 ? -0.5f : 0.5f)); }
+
+// the legacy "%2s" swallowed the checksum delimiter, e.g. "1*"
+static bool sameResult( legacy_pflaa_s &legacy, const nmea_pflaa_s &reader ){
+	char *star = strchr( legacy.acftType, '*' );
+	if( star )
+		*star = 0;
+	return legacy.alarmLevel == reader.alarmLevel && legacy.relNorth == reader.relNorth &&
+			legacy.relEast == reader.relEast && legacy.relVertical == reader.relVertical &&
+			legacy.idType == reader.idType && legacy.ID == reader.ID && legacy.track == reader.track &&
+			centi(legacy.turnRate) == reader.turnRate && centi(legacy.groundSpeed) == reader.groundSpeed &&
+			centi(legacy.climbRate) == reader.climbRate && !strcmp( legacy.acftType, reader.acftType );
+}
+
+// checksum as every parser computed it before NMEAFramer
+static int legacyCheckSum( const char *s ){
+	int cs = 0;
+	int i = 1;
+	while( s[i] != '*' && s[i] != 0 )
+		cs ^= s[i++];
+	return cs;
+}
+
+// whole stream, legacy: copy framer, istringstream PFLAA, float sscanf for the rest
+static float legacy_speed, legacy_course;
+static volatile int legacy_sink;
+static void legacySentence( const char *str ){
+	char s[512];
+	int pos = 0;
+	for( const char *c = str; *c && *c != '\r' && *c != '\n'; c++ )
+		s[pos++] = *c;
+	s[pos++] = '\r';
+	s[pos++] = '\n';
+	s[pos] = 0;
+	int i[11];
+	char c;
+	int cs = 0;
+	const char *star = strchr( s, '*' );
+	if( star )
+		sscanf( star+1, "%02x", &cs );
+	if( cs != legacyCheckSum( s ) )
+		return;
+	legacy_sink = cs;
+	if( !strncmp( s+1, "PFLAA,", 6 ) ){
+		legacy_pflaa_s p;
+		memset( &p, 0, sizeof(p) );
+		legacyPFLAA( s, p );
+	}
+	else if( !strncmp( s+3, "RMC,", 4 ) )
+		sscanf( s+3, "RMC,%*f,%c,%*f,%*c,%*f,%*c,%f,%f,%*d,%*f,%*c*%*02x", &c, &legacy_speed, &legacy_course );
+	else if( !strncmp( s+3, "GGA,", 4 ) )
+		sscanf( s+3, "GGA,%*f,%*f,%*c,%*f,%*c,%*d,%d,%*f,%*f,M,%*f,M,%*f,%*d*%*02x", &i[0] );
+	else if( !strncmp( s+1, "PFLAU,", 6 ) )
+		sscanf( s, "$PFLAU,%d,%d,%d,%d,%d,%d,%d,%d,%d,%x*%02x", &i[0],&i[1],&i[2],&i[3],&i[4],&i[5],&i[6],&i[7],&i[8],&i[9],&i[10] );
+}
+
+// whole stream, NMEAFramer and fixed point NMEAReader
+static int reader_speed, reader_course;
+static volatile int reader_sink;
+static NMEAFramer framer;
+static void readerFrame( const nmea_frame_t &f ){
+	const char *s = f.sentence;
+	int v = 0;
+	char c;
+	if( !strncmp( s+1, "PFLAA,", 6 ) ){
+		nmea_pflaa_s p;
+		memset( &p, 0, sizeof(p) );
+		decodePFLAA( f, p );
+		reader_sink = p.ID + p.climbRate + p.groundSpeed;
+	}
+	else if( !strncmp( s+3, "RMC,", 4 ) )
+		decodeGPRMC( f, c, reader_speed, reader_course );
+	else if( !strncmp( s+3, "GGA,", 4 ) ){
+		NMEAReader r( f );
+		for( int f=0; f<6; f++ )
+			r.skip();
+		if( r.nextInt( v ) )
+			reader_sink = v;
+	}
+	else if( !strncmp( s+1, "PFLAU,", 6 ) ){
+		NMEAReader r( f );
+		for( int f=0; f<9; f++ )
+			r.nextInt( v );
+		unsigned int id = 0;
+		r.nextHex( id );
+		reader_sink = v + id;
+	}
+}
+
+static void readerSentence( const char *s ){
+	for( ; *s; s++ ){
+		if( framer.feed( s ) )
+			readerFrame( framer.frame() );
+	}
+}
+
+static unsigned long long cycles( void (*parse)(const char *) ){
+	unsigned long long start = CYCLES();
+	for( int r=0; r<ROUNDS; r++ )
+		for( unsigned int i=0; i<NUM_PFLAA2_SIM; i++ )
+			parse( pflaa2[i] );
+	return (CYCLES() - start) / ((unsigned long long)ROUNDS * NUM_PFLAA2_SIM);
+}
+
+template <typename S, typename C, typename F>
+static double run( const char *name, const std::vector<C> &corpus, F parse ){
+	volatile unsigned int sink = 0;
+	auto start = std::chrono::steady_clock::now();
+	for( int r=0; r<ROUNDS; r++ ){
+		for( const C &s : corpus ){
+			S p;
+			memset( &p, 0, sizeof(p) );
+			parse( s, p );
+			sink = sink + p.ID + p.relNorth;
+		}
+	}
+	double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	double rate = (double)ROUNDS * corpus.size() / sec;
+	printf( "%-12s %10.0f sentences/s\n", name, rate );
+	return rate;
+}
+
+int main(){
+	std::vector<const char*> corpus;
+	std::vector<nmea_frame_t> frames;
+	for( unsigned int i=0; i<NUM_PFLAA2_SIM; i++ ){
+		if( !strncmp( pflaa2[i], "$PFLAA,", 7 ) ){
+			corpus.push_back( pflaa2[i] );
+			NMEAFramer f;
+			for( const char *c = pflaa2[i]; *c; c++ ){
+				if( f.feed( c ) )
+					frames.push_back( f.frame() );
+			}
+		}
+	}
+	if( frames.size() != corpus.size() ){
+		printf( "framer rejected %d PFLAA sentences\n", (int)(corpus.size() - frames.size()) );
+		return 1;
+	}
+	printf( "PFLAA corpus: %d sentences x %d rounds\n", (int)corpus.size(), ROUNDS );
+
+	int mismatch = 0;
+	for( size_t i=0; i<corpus.size(); i++ ){
+		legacy_pflaa_s a;
+		nmea_pflaa_s b;
+		memset( &a, 0, sizeof(a) );
+		memset( &b, 0, sizeof(b) );
+		legacyPFLAA( corpus[i], a );
+		decodePFLAA( frames[i], b );
+		if( !sameResult( a, b ) ){
+			printf( "mismatch: %s", corpus[i] );
+			mismatch++;
+		}
+	}
+
+	double legacy = run<legacy_pflaa_s>( "istringstream", corpus, legacyPFLAA );
+	double reader = run<nmea_pflaa_s>( "NMEAReader", frames, decodePFLAA );
+	printf( "speedup      %10.1fx\n", reader / legacy );
+
+	printf( "\nfull pflaa2.h stream: %d sentences x %d rounds\n", (int)NUM_PFLAA2_SIM, ROUNDS );
+	unsigned long long c_legacy = cycles( legacySentence );
+	unsigned long long c_reader = cycles( readerSentence );
+	if( framer.getBadChecksum() || framer.getOverflow() ){
+		printf( "framer: %u bad checksum, %u overflow\n", framer.getBadChecksum(), framer.getOverflow() );
+		mismatch++;
+	}
+	printf( "float/sscanf  %10llu cycles/sentence\n", c_legacy );
+	printf( "fixed point   %10llu cycles/sentence\n", c_reader );
+	if( centi(legacy_speed) != reader_speed || centi(legacy_course) != reader_course ){
+		printf( "GPRMC mismatch: %f/%d %f/%d\n", legacy_speed, reader_speed, legacy_course, reader_course );
+		mismatch++;
+	}
+	return mismatch ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * span_bench.cpp - host side count of the SPI transfers of solid fills and lines
+ *
+ * Runs eglib_ClearScreen() on the 320x172 screen, the three tetragons of
+ * TargetManager::drawAirplane(), a filled disc and the circles of the radar
+ * through the ILI9341 driver, with a HAL stand-in counting the transfers (one
+ * esend(), DC level plus SPI.transfer(), each) and the bytes sent. Of these,
+ * protocol bytes are commands and their parameters (MADCTL, CASET, RASET),
+ * everything but the pixels after RAMWR and RAMWRC.
+ *
+ * The time on target is estimated as transfers * T_TRANSFER + bytes at the
+ * SPI clock of AdaptUGC. T_TRANSFER, the cost of one esend() besides its
+ * bytes, is an estimate for the Arduino SPI.transfer() on the ESP32-S2; the
+ * "Frame" log line of TargetManager gives transfers and bytes on target.
+ *
+ * Build and run from the repository root:
+ *   E=components/eglib; gcc -O2 -c -Itools/host -I$E -I$E/eglib -I$E/eglib/hal/four_wire_spi/esp32 \
+ *     $E/eglib.c $E/eglib/display.c $E/eglib/drawing.c $E/eglib/hal.c $E/eglib/display/ili9341.c && \
+ *   g++ -O2 -std=c++17 -Itools/host -I$E -I$E/eglib tools/span_bench.cpp *.o -o span_bench && \
+ *   rm *.o && ./span_bench
+ */
+
+#include <cstdio>
+extern "C" {
+#include "eglib.h"
+#include <eglib/hal.h>
+#include <eglib/display/ili9341.h>
+}
+
+#define DISPLAY_W  320
+#define DISPLAY_H  172
+#define F_SPI      (13111111*3)   // Hz, as AdaptUGC
+#define T_TRANSFER 2.0            // us per esend(), estimate
+
+static uint32_t transfers, bytes, protocol;
+static bool pixels;   // data sent are pixels
+
+extern "C" {
+static void hal_init( eglib_t * ){}
+static void hal_sleep( eglib_t * ){}
+static void hal_delay_ns( eglib_t *, uint32_t ){}
+static void hal_set_reset( eglib_t *, bool ){}
+static bool hal_get_busy( eglib_t * ){ return false; }
+static void hal_comm( eglib_t * ){}
+static void hal_send( eglib_t *, enum hal_dc_t dc, uint8_t *b, uint32_t length ){
+	transfers++;
+	bytes += length;
+	if( dc == HAL_COMMAND )
+		pixels = b[length-1] == 0x2C || b[length-1] == 0x3C;
+	if( dc == HAL_COMMAND || !pixels )
+		protocol += length;
+}
+}
+static const hal_t counting = { hal_init, hal_sleep, hal_sleep, hal_delay_ns, hal_set_reset, hal_get_busy, hal_comm, hal_send, hal_comm };
+
+static ili9341_config_t config = {
+	.width = DISPLAY_W,
+	.height = DISPLAY_W,
+	.color = EGLIB_RGB565 ? ILI9341_COLOR_16_BIT : ILI9341_COLOR_18_BIT,
+	.page_address = ILI9341_PAGE_ADDRESS_TOP_TO_BOTTOM,
+	.colum_address = ILI9341_COLUMN_ADDRESS_RIGHT_TO_LEFT,
+	.page_column_order = ILI9341_PAGE_COLUMN_ORDER_REVERSE,
+	.vertical_refresh = ILI9341_VERTICAL_REFRESH_TOP_TO_BOTTOM,
+	.horizontal_refresh = ILI9341_HORIZONTAL_REFRESH_RIGHT_TO_LEFT,
+};
+
+static void report( const char *what ){
+	double us = transfers*T_TRANSFER + bytes*8e6/F_SPI;
+	printf( "%-20s %7u transfers %7u bytes (%6u protocol)  ~%8.0f us\n", what, transfers, bytes, protocol, us );
+	transfers = bytes = protocol = 0;
+}
+
+int main(){
+	eglib_t e;
+	eglib_Init( &e, &counting, nullptr, &ili9341, &config );
+	eglib_setClipRange( &e, 0, 0, DISPLAY_W, DISPLAY_H );   // as AdaptUGC::begin()
+	transfers = bytes = protocol = 0;
+
+	eglib_SetIndexColor( &e, 0, 0, 0, 0 );
+	eglib_ClearScreen( &e );
+	report( "clearScreen()" );
+
+	int x = DISPLAY_W/2, y = DISPLAY_H/2;
+	eglib_SetIndexColor( &e, 0, 255, 255, 255 );
+	eglib_DrawTetragon( &e, x-15, y-1, x-15, y+1, x+15, y+1, x+15, y-1 );
+	eglib_DrawTetragon( &e, x-1, y+10, x-1, y-6, x+1, y-6, x+1, y+10 );
+	eglib_DrawTetragon( &e, x-4, y+10, x-4, y+9, x+4, y+9, x+4, y+10 );
+	report( "airplane tetragons" );
+
+	eglib_DrawDisc( &e, x, y, 12, EGLIB_DRAW_ALL );
+	report( "disc, radius 12" );
+
+	eglib_DrawCircle( &e, x, y, 12, EGLIB_DRAW_ALL );
+	report( "circle, radius 12" );
+	eglib_DrawCircle( &e, x, y, 25, EGLIB_DRAW_ALL );
+	eglib_DrawCircle( &e, x, y, 50, EGLIB_DRAW_ALL );
+	eglib_DrawCircle( &e, x, y, 75, EGLIB_DRAW_ALL );
+	report( "range circles 25-75" );
+	return 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * spi_replay.cpp - host side replay of the radar screen through the ILI9341 driver
+ *
+ * Replays a scripted scenario, eight targets circling the own airplane, the
+ * nearest one with its circle and info fields, the best climber with its climb
+ * rate, twice through eglib and the ILI9341 driver:
+ *
+ *   before: as the former Target and TargetManager code, erasing every changed
+ *           symbol by drawing it again in black before drawing it anew
+ *   after:  the scene handed to the Compositor, only damaged rectangles sent
+ *
+ * A HAL stand-in counts the bytes sent and keeps the display memory (CASET,
+ * RASET, RAMWR, RAMWRC). After each frame both memories are compared with a third one
+ * the scene was drawn onto as a whole, after clearing it. Prints SPI bytes per
+ * frame for both and the number of frames whose screen differed: erasing in
+ * black punches holes into overlapping symbols, the Compositor should not.
+ * A second run of the Compositor alone counts the glyphs drawn from the glyph
+ * cache of eglib and those rendered anew.
+ *
+ * The FreeFont sources are generated at build time and not in the tree, the
+ * replay uses the Adobe Helvetica Bold instead.
+ *
+ * Build and run from the repository root:
+ *   E=components/eglib; gcc -O2 -c -Itools/host -I$E -I$E/eglib -I$E/eglib/hal/four_wire_spi/esp32 \
+ *     $E/eglib.c $E/eglib/display.c $E/eglib/drawing.c $E/eglib/hal.c $E/eglib/display/ili9341.c \
+ *     $E/eglib/display/frame_buffer.c $E/eglib/display/tile.c $E/eglib/hal/four_wire_spi/none.c \
+ *     $E/eglib/drawing/fonts/adobe/helvetica_bold.c $E/eglib/drawing/fonts/adobe/new_century_schoolbook_roman.c && \
+ *   g++ -O2 -std=c++17 -Itools/host -I$E -I$E/eglib -Imain tools/spi_replay.cpp main/Compositor.cpp *.o -lm -o spi_replay && \
+ *   rm *.o && ./spi_replay
+ *
+ * Add -DEGLIB_RGB565=1 to both compile lines for the RGB565 pixel format,
+ * -DDISPLAY_W=240 -DDISPLAY_H=320 for the 2.4 inch display.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include "Compositor.h"
+extern "C" {
+#include <eglib/display/ili9341.h>
+#include <eglib/drawing/fonts.h>
+}
+
+#ifndef DISPLAY_W
+#define DISPLAY_W 320
+#define DISPLAY_H 172
+#endif
+#define Y_OFFSET  34      // rows the driver adds
+#define TARGETS   8
+#define FRAMES    600     // 2 minutes at 5 frames/s
+#define SIDE      18
+#define BPP       (int)sizeof(pixel_t)   // bytes per pixel
+
+static const color_t BLACK = { 0, 0, 0 }, WHITE = { 255, 255, 255 }, GREEN = { 0, 255, 0 }, BLUE = { 0, 0, 255 };
+static const struct font_t *font_big = &font_Adobe_HelveticaBold_24px;    // ucg_font_fub20_hf
+static const struct font_t *font_unit = &font_Adobe_HelveticaBold_18px;   // ucg_font_fub14_hf
+static const struct font_t *font_ncen = &font_Adobe_NewCenturySchoolbookRoman_20px;
+
+//
+// HAL counting the bytes and keeping the display memory
+//
+
+struct Panel {
+	uint32_t bytes = 0;
+	uint8_t cmd = 0;
+	int arg = 0;
+	uint8_t args[4];
+	int x0 = 0, x1 = 0, y0 = 0, y1 = 0, x = 0, y = 0, sub = 0;
+	uint8_t px[BPP];
+	uint8_t mem[DISPLAY_H + Y_OFFSET][DISPLAY_W][BPP];
+
+	void data( uint8_t b ){
+		switch( cmd ){
+		case 0x2A: case 0x2B:
+			if( arg < 4 )
+				args[arg++] = b;
+			if( arg == 4 ){
+				int s = args[0] << 8 | args[1], e = args[2] << 8 | args[3];
+				if( cmd == 0x2A ){ x0 = s; x1 = e; }
+				else { y0 = s; y1 = e; }
+			}
+			break;
+		case 0x2C: case 0x3C:
+			px[sub++] = EGLIB_RGB565 ? b : b & 0xFC;   // 18 bit color, the low bits are not kept
+			if( sub < BPP )
+				break;
+			sub = 0;
+			if( x >= 0 && x < DISPLAY_W && y >= 0 && y < DISPLAY_H + Y_OFFSET )
+				memcpy( mem[y][x], px, BPP );
+			if( ++x > x1 ){
+				x = x0;
+				if( ++y > y1 )
+					y = y0;
+			}
+			break;
+		}
+	}
+	void send( enum hal_dc_t dc, uint8_t *b, uint32_t len ){
+		bytes += len;
+		if( dc == HAL_COMMAND ){
+			cmd = b[len-1];
+			arg = sub = 0;
+			if( cmd == 0x2C ){   // RAMWRC goes on where the last write stopped
+				x = x0;
+				y = y0;
+			}
+			return;
+		}
+		while( len-- )
+			data( *b++ );
+	}
+	bool operator!=( const Panel &o ) const { return memcmp( mem[Y_OFFSET], o.mem[Y_OFFSET], sizeof(mem) - sizeof(mem[0])*Y_OFFSET ); }
+};
+
+extern "C" {
+static void hal_init( eglib_t * ){}
+static void hal_sleep( eglib_t * ){}
+static void hal_delay_ns( eglib_t *, uint32_t ){}
+static void hal_set_reset( eglib_t *, bool ){}
+static bool hal_get_busy( eglib_t * ){ return false; }
+static void hal_comm( eglib_t * ){}
+static void hal_send( eglib_t *e, enum hal_dc_t dc, uint8_t *bytes, uint32_t length ){ ((Panel *)e->hal.config_ptr)->send( dc, bytes, length ); }
+}
+static const hal_t counting = { hal_init, hal_sleep, hal_sleep, hal_delay_ns, hal_set_reset, hal_get_busy, hal_comm, hal_send, hal_comm };
+
+//
+// Scenario
+//
+
+struct Tgt {
+	int x, y, tri[6];
+	bool nearest, climber;
+	char climb[8];
+};
+
+struct Frame {
+	Tgt t[TARGETS];
+	int radius;
+	int nx, ny;
+	char dist[16], id[16], alt[16], var[16];
+};
+
+static void scenario( int f, Frame &s ){
+	for( int i=0; i<TARGETS; i++ ){
+		Tgt &t = s.t[i];
+		float r = 25 + 9*i;
+		float a = 0.7f*i + f*(0.004f + 0.002f*(i%3))*((i&1) ? -1 : 1);   // rad
+		float h = a + ((i&1) ? -M_PI/2 : M_PI/2);                           // heading along the circle
+		t.x = DISPLAY_W/2 + lrintf( 1.6f*r*sinf( a ) );
+		t.y = DISPLAY_H/2 - lrintf( 0.8f*r*cosf( a ) );
+		float axt = t.x - SIDE/4.0f*sinf( h ), ayt = t.y + SIDE/4.0f*cosf( h );
+		float rad = h - M_PI/2;
+		t.tri[0] = lrintf( axt + SIDE*cosf( rad ) );
+		t.tri[1] = lrintf( ayt + SIDE*sinf( rad ) );
+		t.tri[2] = lrintf( axt + SIDE/2.0f*cosf( rad + 2*M_PI/3 ) );
+		t.tri[3] = lrintf( ayt + SIDE/2.0f*sinf( rad + 2*M_PI/3 ) );
+		t.tri[4] = lrintf( axt + SIDE/2.0f*cosf( rad - 2*M_PI/3 ) );
+		t.tri[5] = lrintf( ayt + SIDE/2.0f*sinf( rad - 2*M_PI/3 ) );
+		t.nearest = i == 0;
+		t.climber = i == 3;
+		snprintf( t.climb, sizeof(t.climb), "%d", 2 + (f/50)%3 );
+	}
+	s.radius = 25;
+	s.nx = DISPLAY_W/2 - 5;
+	s.ny = DISPLAY_H/2 - s.radius + 6;
+	snprintf( s.dist, sizeof(s.dist), "%.2f", 0.40 + 0.002*(f%100) );
+	snprintf( s.id, sizeof(s.id), "D-1234 XY" );
+	snprintf( s.alt, sizeof(s.alt), "+%d", 50 + f/25 );
+	snprintf( s.var, sizeof(s.var), "%+.1f", 1.0 + 0.1*((f/10)%10) );
+}
+
+//
+// before: erase by drawing again in black
+//
+
+static void text( eglib_t *e, const struct font_t *font, int x, int y, color_t c, const char *s ){
+	eglib_SetIndexColor( e, 0, c.r, c.g, c.b );
+	eglib_SetFont( e, font );
+	eglib_DrawText( e, x, y, s );
+}
+
+static void symbol( eglib_t *e, const Tgt &t, bool erase ){
+	color_t c = erase ? BLACK : GREEN;
+	eglib_SetIndexColor( e, 0, c.r, c.g, c.b );
+	eglib_DrawFilledTriangle( e, t.tri[0], t.tri[1], t.tri[2], t.tri[3], t.tri[4], t.tri[5] );
+	if( t.climber )
+		text( e, font_ncen, t.x-4, t.y-SIDE, c, t.climb );
+	eglib_SetIndexColor( e, 0, c.r, c.g, c.b );
+	if( t.nearest )
+		eglib_DrawCircle( e, t.x, t.y, (SIDE*3+2)/4, EGLIB_DRAW_ALL );
+}
+
+static void infoField( eglib_t *e, int x, int y, bool right, char *old, const char *cur ){
+	if( !strcmp( old, cur ) )
+		return;
+	if( old[0] )
+		text( e, font_big, right ? DISPLAY_W-5-eglib_GetTextWidth( e, old ) : x, y, BLACK, old );
+	eglib_SetFont( e, font_big );
+	text( e, font_big, right ? DISPLAY_W-5-eglib_GetTextWidth( e, cur ) : x, y, WHITE, cur );
+	strcpy( old, cur );
+}
+
+static void before( eglib_t *e, int f, const Frame &s, Frame &o ){
+	int x = DISPLAY_W/2, y = DISPLAY_H/2;
+	eglib_SetIndexColor( e, 0, 255, 255, 255 );
+	eglib_DrawTetragon( e, x-15, y-1, x-15, y+1, x+15, y+1, x+15, y-1 );
+	eglib_DrawTetragon( e, x-1, y+10, x-1, y-6, x+1, y-6, x+1, y+10 );
+	eglib_DrawTetragon( e, x-4, y+10, x-4, y+9, x+4, y+9, x+4, y+10 );
+	if( !(f%5) ){   // the former !(_tick % 20) at 4 ticks per frame
+		if( f ){
+			text( e, font_ncen, o.nx, o.ny, BLACK, "N" );
+			eglib_DrawCircle( e, x, y, o.radius, EGLIB_DRAW_ALL );
+		}
+		text( e, font_ncen, s.nx, s.ny, GREEN, "N" );
+		eglib_DrawCircle( e, x, y, s.radius, EGLIB_DRAW_ALL );
+	}
+	for( int i=0; i<TARGETS; i++ ){
+		const Tgt &t = s.t[i], &p = o.t[i];
+		if( f && !memcmp( t.tri, p.tri, sizeof(t.tri) ) && !strcmp( t.climb, p.climb ) )
+			continue;
+		if( f )
+			symbol( e, p, true );
+		symbol( e, t, false );
+	}
+	infoField( e, DISPLAY_W-5, 30, true, o.dist, s.dist );
+	infoField( e, DISPLAY_W-5, DISPLAY_H-7, true, o.id, s.id );
+	infoField( e, 5, DISPLAY_H-7, false, o.alt, s.alt );
+	infoField( e, 5, 30, false, o.var, s.var );
+	eglib_SetFont( e, font_unit );
+	text( e, font_unit, DISPLAY_W-5-eglib_GetTextWidth( e, "ID" ), DISPLAY_H-37, BLUE, "ID" );
+	text( e, font_unit, DISPLAY_W-5-eglib_GetTextWidth( e, "Dis km" ), 50, BLUE, "Dis km" );
+	text( e, font_unit, 5, 50, BLUE, "Var m/s" );
+	text( e, font_unit, 5, DISPLAY_H-37, BLUE, "Alt m" );
+	Frame keep = o;
+	o = s;
+	memcpy( o.dist, keep.dist, sizeof(o.dist) );   // infoField() tracks these
+	memcpy( o.id, keep.id, sizeof(o.id) );
+	memcpy( o.alt, keep.alt, sizeof(o.alt) );
+	memcpy( o.var, keep.var, sizeof(o.var) );
+}
+
+//
+// after: the scene handed to the Compositor, or drawn as a whole onto a
+// cleared screen for reference, in the same order
+//
+
+struct Out {
+	virtual void tetragon( int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3, color_t c ) = 0;
+	virtual void triangle( int x0, int y0, int x1, int y1, int x2, int y2, color_t c ) = 0;
+	virtual void circle( int x, int y, int r, color_t c ) = 0;
+	virtual void text( int x, int y, const struct font_t *font, color_t c, const char *s ) = 0;
+};
+
+struct ToCompositor: Out {
+	void tetragon( int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3, color_t c ){ Compositor::tetragon( x0, y0, x1, y1, x2, y2, x3, y3, c ); }
+	void triangle( int x0, int y0, int x1, int y1, int x2, int y2, color_t c ){ Compositor::triangle( x0, y0, x1, y1, x2, y2, c ); }
+	void circle( int x, int y, int r, color_t c ){ Compositor::circle( x, y, r, c ); }
+	void text( int x, int y, const struct font_t *font, color_t c, const char *s ){ Compositor::text( x, y, font, FONT_MIDDLE, c, s ); }
+};
+
+struct ToDisplay: Out {
+	eglib_t *e;
+	void color( color_t c ){ eglib_SetIndexColor( e, 0, c.r, c.g, c.b ); }
+	void tetragon( int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3, color_t c ){ color( c ); eglib_DrawTetragon( e, x0, y0, x1, y1, x2, y2, x3, y3 ); }
+	void triangle( int x0, int y0, int x1, int y1, int x2, int y2, color_t c ){ color( c ); eglib_DrawFilledTriangle( e, x0, y0, x1, y1, x2, y2 ); }
+	void circle( int x, int y, int r, color_t c ){ color( c ); eglib_DrawCircle( e, x, y, r, EGLIB_DRAW_ALL ); }
+	void text( int x, int y, const struct font_t *font, color_t c, const char *s ){ ::text( e, font, x, y, c, s ); }
+};
+
+static void scene( eglib_t *e, Out &out, const Frame &s ){
+	int x = DISPLAY_W/2, y = DISPLAY_H/2;
+	out.tetragon( x-15, y-1, x-15, y+1, x+15, y+1, x+15, y-1, WHITE );
+	out.tetragon( x-1, y+10, x-1, y-6, x+1, y-6, x+1, y+10, WHITE );
+	out.tetragon( x-4, y+10, x-4, y+9, x+4, y+9, x+4, y+10, WHITE );
+	out.text( s.nx, s.ny, font_ncen, GREEN, "N" );
+	out.circle( x, y, s.radius, GREEN );
+	for( int i=0; i<TARGETS; i++ ){
+		const Tgt &t = s.t[i];
+		out.triangle( t.tri[0], t.tri[1], t.tri[2], t.tri[3], t.tri[4], t.tri[5], GREEN );
+		if( t.climber )
+			out.text( t.x-4, t.y-SIDE, font_ncen, GREEN, t.climb );
+		if( t.nearest )
+			out.circle( t.x, t.y, (SIDE*3+2)/4, GREEN );
+	}
+	eglib_SetFont( e, font_big );
+	out.text( DISPLAY_W-5-eglib_GetTextWidth( e, s.dist ), 30, font_big, WHITE, s.dist );
+	out.text( DISPLAY_W-5-eglib_GetTextWidth( e, s.id ), DISPLAY_H-7, font_big, WHITE, s.id );
+	out.text( 5, DISPLAY_H-7, font_big, WHITE, s.alt );
+	out.text( 5, 30, font_big, WHITE, s.var );
+	eglib_SetFont( e, font_unit );
+	out.text( DISPLAY_W-5-eglib_GetTextWidth( e, "ID" ), DISPLAY_H-37, font_unit, BLUE, "ID" );
+	out.text( DISPLAY_W-5-eglib_GetTextWidth( e, "Dis km" ), 50, font_unit, BLUE, "Dis km" );
+	out.text( 5, 50, font_unit, BLUE, "Var m/s" );
+	out.text( 5, DISPLAY_H-37, font_unit, BLUE, "Alt m" );
+}
+
+static ili9341_config_t config = {
+	.width = DISPLAY_W,
+	.height = DISPLAY_W,
+	.color = EGLIB_RGB565 ? ILI9341_COLOR_16_BIT : ILI9341_COLOR_18_BIT,
+	.page_address = ILI9341_PAGE_ADDRESS_TOP_TO_BOTTOM,
+	.colum_address = ILI9341_COLUMN_ADDRESS_LEFT_TO_RIGHT,
+	.page_column_order = ILI9341_PAGE_COLUMN_ORDER_NORMAL,
+	.vertical_refresh = ILI9341_VERTICAL_REFRESH_TOP_TO_BOTTOM,
+	.horizontal_refresh = ILI9341_HORIZONTAL_REFRESH_LEFT_TO_RIGHT,
+};
+
+static void init( eglib_t *e, Panel *p ){
+	eglib_Init( e, &counting, p, &ili9341, &config );
+	eglib_setFontOrigin( e, FONT_MIDDLE );   // drawN() leaves it so for the radar screen
+	p->bytes = 0;
+}
+
+int main(){
+	static Panel before_p, after_p, ref_p;
+	eglib_t before_e, after_e, ref_e;
+	init( &before_e, &before_p );
+	init( &after_e, &after_p );
+	init( &ref_e, &ref_p );
+	Compositor::begin( &after_e, DISPLAY_W, DISPLAY_H, BLACK );
+	ToCompositor comp;
+	ToDisplay ref;
+	ref.e = &ref_e;
+	Frame s, o;
+	memset( &o, 0, sizeof(o) );
+	int differ_before = 0, differ_after = 0;
+	for( int f=0; f<FRAMES; f++ ){
+		scenario( f, s );
+		before( &before_e, f, s, o );
+		Compositor::beginFrame();
+		scene( &after_e, comp, s );
+		Compositor::endFrame();
+		memset( ref_p.mem, 0, sizeof(ref_p.mem) );
+		scene( &ref_e, ref, s );
+		differ_before += before_p != ref_p;
+		differ_after += after_p != ref_p;
+	}
+	printf( "%d targets, %d frames: before %u SPI bytes/frame, after %u SPI bytes/frame (%.1f%%)\n",
+			TARGETS, FRAMES, before_p.bytes/FRAMES, after_p.bytes/FRAMES, 100.0*after_p.bytes/before_p.bytes );
+	printf( "after: %u rects/frame, %u pixels/frame, %u dropped\n",
+			Compositor::takeRects()/FRAMES, Compositor::takePixels()/FRAMES, Compositor::takeDropped() );
+	printf( "frames differing from the scene drawn as a whole: before %d, after %d\n", differ_before, differ_after );
+
+	// once more with the Compositor alone, as on the device, for the glyph cache
+	uint32_t hits = eglib_glyph_hits, misses = eglib_glyph_misses;
+	for( int f=0; f<FRAMES; f++ ){
+		scenario( f, s );
+		Compositor::beginFrame();
+		scene( &after_e, comp, s );
+		Compositor::endFrame();
+	}
+	printf( "after: %.1f glyphs/frame from the cache, %.1f rendered\n",
+			(double)(eglib_glyph_hits-hits)/FRAMES, (double)(eglib_glyph_misses-misses)/FRAMES );
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * target_bench.cpp - host side benchmark of the TargetManager nearest / best climber scan
+ *
+ * Compares the scan over whole Target objects (the layout before the hot/cold
+ * split, one std::map node per target) with the scan over the structure of
+ * arrays of TargetStore, for 10, 50 and 100 targets. Prints the memory used
+ * and CPU cycles per scan (TSC on x86 hosts).
+ *
+ * The ESP32-S2 has no data cache in front of internal SRAM, there the gain is
+ * the shorter loop body rather than cache lines, see the "Scan" log line of
+ * TargetManager for the numbers on target.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -std=c++17 -Imain tools/target_bench.cpp -o target_bench && ./target_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+#include "NMEA.h"
+
+#define ROUNDS 20000
+#define AGEOUT 120
+#define MAP_NODE_OVERHEAD 16   // rb tree node header on a 32 bit heap, plus the key
+
+// Target as it was before the split, hot and cold fields mixed
+class LegacyTarget {
+public:
+	virtual ~LegacyTarget() {};
+	nmea_pflaa_s pflaa;
+	int age;
+	int tick, raw_tick, last_pflaa_time;
+	float dist_buzz;
+	int _buzzedHoldDown, rel_target_heading;
+	float rel_target_dir;
+	int old_track;
+	float dist, prox;
+	int x, y, old_ax, old_ay, old_x0, old_y0, old_x1, old_y1, old_x2, old_y2, old_closest, old_sidelen, old_cirsize, old_cirsizeteam;
+	char *reg, *comp;
+	bool is_nearest, _isPriority, do_follow, is_best, alarm, firstDraw;
+	int alarm_timer, old_climb, old_x, old_y, old_size, tek_climb, last_groundspeed;
+};
+
+// cold part after the split, the hot fields moved to the arrays below
+class ColdTarget {
+public:
+	virtual ~ColdTarget() {};
+	int slot;
+	nmea_pflaa_s pflaa;
+	int tick, raw_tick, last_pflaa_time;
+	float dist_buzz;
+	int _buzzedHoldDown, rel_target_heading;
+	float rel_target_dir;
+	int old_track;
+	int old_ax, old_ay, old_x0, old_y0, old_x1, old_y1, old_x2, old_y2, old_closest, old_sidelen, old_cirsize, old_cirsizeteam;
+	char *reg, *comp;
+	bool do_follow, firstDraw;
+	int alarm_timer, old_climb, old_x, old_y, old_size, tek_climb, last_groundspeed;
+};
+
+#define TGT_NEAREST 1
+#define TGT_BEST    2
+#define TGT_ALARM   4
+#define MAX 128
+static unsigned int id[MAX];
+static float    dist[MAX];
+static float    prox[MAX];
+static int16_t  x[MAX], y[MAX];
+static uint16_t age[MAX];
+static int      climb[MAX];
+static uint8_t  flags[MAX];
+#define HOT_BYTES (sizeof(id[0])+sizeof(dist[0])+sizeof(prox[0])+sizeof(x[0])+sizeof(y[0])+sizeof(age[0])+sizeof(climb[0])+sizeof(flags[0]))
+
+static volatile unsigned int sink;
+
+static unsigned long long legacyScan( std::map<unsigned int, LegacyTarget> &targets ){
+	unsigned long long start = CYCLES();
+	for( int r=0; r<ROUNDS; r++ ){
+		float min_dist = 10000.0f;
+		int max_climb = -1000*NMEA_CENTI;
+		unsigned int min_id = 0, maxcl_id = 0;
+		int id_timer = r & 1;
+		for( auto &kv : targets ){
+			LegacyTarget &t = kv.second;
+			t.is_nearest = false;
+			t.is_best = false;
+			if( t.age < AGEOUT ){
+				if( t.alarm ) id_timer = 0;
+				if( t.pflaa.climbRate > max_climb ){ max_climb = t.pflaa.climbRate; maxcl_id = kv.first; }
+				if( !id_timer && t.prox < min_dist ){ min_dist = t.dist; min_id = kv.first; }
+			}
+		}
+		sink = min_id + maxcl_id;
+	}
+	return (CYCLES() - start) / ROUNDS;
+}
+
+static unsigned long long soaScan( int num ){
+	unsigned long long start = CYCLES();
+	for( int r=0; r<ROUNDS; r++ ){
+		float min_dist = 10000.0f;
+		int max_climb = -1000*NMEA_CENTI;
+		unsigned int min_id = 0, maxcl_id = 0;
+		int id_timer = r & 1;
+		for( int i=0; i<num; i++ ){
+			flags[i] &= ~(TGT_NEAREST | TGT_BEST);
+			if( age[i] >= AGEOUT ) continue;
+			if( flags[i] & TGT_ALARM ) id_timer = 0;
+			if( climb[i] > max_climb ){ max_climb = climb[i]; maxcl_id = id[i]; }
+			if( !id_timer && prox[i] < min_dist ){ min_dist = dist[i]; min_id = id[i]; }
+		}
+		sink = min_id + maxcl_id;
+	}
+	return (CYCLES() - start) / ROUNDS;
+}
+
+int main(){
+	printf( "sizeof Target: %d bytes before, %d cold + %d hot after\n\n",
+			(int)sizeof(LegacyTarget), (int)sizeof(ColdTarget), (int)HOT_BYTES );
+	printf( "targets   map bytes  store bytes   map cycles  SoA cycles\n" );
+	const int sizes[] = { 10, 50, 100 };
+	for( int n : sizes ){
+		std::map<unsigned int, LegacyTarget> targets;
+		srand( n );
+		for( int i=0; i<n; i++ ){
+			unsigned int tid = 0xD00000 + rand() % 0xFFFFF;
+			LegacyTarget t{};
+			t.age = rand() % (2*AGEOUT);
+			t.dist = t.prox = (rand() % 10000) / 1000.0f;
+			t.pflaa.climbRate = rand() % 800 - 400;
+			t.alarm = !(rand() % 20);
+			targets[tid] = t;
+		}
+		int num = 0;
+		for( auto &kv : targets ){
+			id[num] = kv.first;
+			dist[num] = kv.second.dist;
+			prox[num] = kv.second.prox;
+			age[num] = kv.second.age;
+			climb[num] = kv.second.pflaa.climbRate;
+			flags[num] = kv.second.alarm ? TGT_ALARM : 0;
+			num++;
+		}
+		unsigned long long c_map = legacyScan( targets );
+		unsigned long long c_soa = soaScan( num );
+		printf( "%7d %11d %12d %12llu %11llu\n", num,
+				(int)(num * (sizeof(LegacyTarget) + MAP_NODE_OVERHEAD)),
+				(int)(num * (sizeof(ColdTarget) + HOT_BYTES)), c_map, c_soa );
+	}
+	printf( "\nthe store is allocated statically for TARGET_MAX targets (TARGET_TABLE_SLOTS*3/4),\n"
+			"sizes are host sizes, pointers are 4 bytes on the ESP32-S2\n" );
+	return 0;
+}
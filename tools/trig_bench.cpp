@@ -0,0 +1,150 @@
+/*
+ * trig_bench.cpp - host side benchmark of the per target update of Target
+ *
+ * Runs the geometry of Target::recalc() and Target::drawFlarmTarget() for
+ * random PFLAA positions, once with the former libm code (atan2, two sqrt,
+ * log, sin/cos over the double D2R) and once with the binary angle and LUT
+ * functions of FixMath.h. Prints CPU cycles per target (TSC on x86 hosts) and
+ * the largest deviation in pixels.
+ *
+ * The host has an FPU, the ESP32-S2 has none: there every float operation of
+ * the libm path is a soft float library call, so the host ratio understates
+ * the gain on target.
+ *
+ * Build and run from the repository root:
+ *   g++ -O2 -std=c++17 -Imain tools/trig_bench.cpp main/FixMath.cpp -o trig_bench && ./trig_bench
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0
+#endif
+#include "FixMath.h"
+
+#define D2R(x) ((x)*(M_PI/180.0))
+#define R2D(x) ((x)*(180.0/M_PI))
+#define SCALE 30
+#define DISPLAY_W 240
+#define DISPLAY_H 320
+#define SIDE 18
+#define N 4096
+#define ROUNDS 50
+
+typedef struct {
+	int relNorth, relEast, relVertical, track;   // m, deg
+} pos_t;
+
+typedef struct {
+	int x, y;
+	int tri[6];
+	float dist, prox;
+} out_t;
+
+static float zoom = 1.25f;
+static bool log_scale = true;
+
+static float normalizeDeg180( float a ){
+	while( a < -180.0 ) a += 360.0;
+	while( a >= 180.0 ) a -= 360.0;
+	return a;
+}
+
+static float angleDiffDeg( float a1, float a2 ){
+	return normalizeDeg180( normalizeDeg180( a1 ) - normalizeDeg180( a2 ) );
+}
+
+static void legacy( const pos_t &p, int course_centi, out_t &o ){
+	float course = course_centi / 100.0f;
+	int heading = rint( angleDiffDeg( (float)p.track, course ) );
+	float dir = angleDiffDeg( R2D( atan2( p.relEast, p.relNorth ) ), course );
+	float dist = sqrt( p.relNorth*p.relNorth + p.relEast*p.relEast ) / 1000.0f;
+	float relV = p.relVertical / 1000.0f;
+	float prox = sqrt( relV*relV + dist*dist );
+	float pix = std::max( 20.0f, zoom*(log_scale ? std::log( 2+dist ) : dist)*SCALE );
+	o.dist = dist;
+	o.prox = prox;
+	o.x = (int16_t)(DISPLAY_W/2 + pix*sin( D2R( dir ) ));
+	o.y = (int16_t)(DISPLAY_H/2 - pix*cos( D2R( dir ) ));
+	float radians = D2R( heading-90.0f );
+	float axt = o.x - SIDE/4.0f*sin( D2R( (float)heading ) );
+	float ayt = o.y + SIDE/4.0f*cos( D2R( (float)heading ) );
+	o.tri[0] = rint( axt + SIDE*cos( radians ) );
+	o.tri[1] = rint( ayt + SIDE*sin( radians ) );
+	o.tri[2] = rint( axt + SIDE/2.0f*cos( radians+2*M_PI/3 ) );
+	o.tri[3] = rint( ayt + SIDE/2.0f*sin( radians+2*M_PI/3 ) );
+	o.tri[4] = rint( axt + SIDE/2.0f*cos( radians-2*M_PI/3 ) );
+	o.tri[5] = rint( ayt + SIDE/2.0f*sin( radians-2*M_PI/3 ) );
+}
+
+// as Target::recalc() and drawFlarmTarget()
+static inline int logPix( int m ){
+	return (SCALE * (fixLn( 2000 + m ) - 452707) + 0x8000) >> 16;
+}
+
+static void fixed( const pos_t &p, int course_centi, out_t &o ){
+	bangle_t course = bangleFromCentiDeg( course_centi );
+	bangle_t heading = bangleFromCentiDeg( p.track*100 ) - course;
+	bangle_t dir = fixAtan2( p.relEast, p.relNorth ) - course;
+	int dist = fixSqrt( p.relNorth*p.relNorth + p.relEast*p.relEast );
+	int prox = fixSqrt( dist*dist + p.relVertical*p.relVertical );
+	int zoom_q8 = zoom*256;
+	int pix = std::max( 20, log_scale ? (zoom_q8 * logPix( dist )) >> 8
+	                                  : (int)(((uint32_t)dist * zoom_q8 * SCALE / 1000) >> 8) );
+	o.dist = dist*0.001f;
+	o.prox = prox*0.001f;
+	o.x = DISPLAY_W/2 + fixMul( pix, fixSin( dir ) );
+	o.y = DISPLAY_H/2 - fixMul( pix, fixCos( dir ) );
+	bangle_t radians = heading - BANGLE_90;
+	int axt = o.x*FIX_ONE - SIDE*fixSin( heading )/4;
+	int ayt = o.y*FIX_ONE + SIDE*fixCos( heading )/4;
+	o.tri[0] = (axt + SIDE*fixCos( radians ) + FIX_ONE/2) >> 15;
+	o.tri[1] = (ayt + SIDE*fixSin( radians ) + FIX_ONE/2) >> 15;
+	o.tri[2] = (axt + SIDE*fixCos( radians+BANGLE_120 )/2 + FIX_ONE/2) >> 15;
+	o.tri[3] = (ayt + SIDE*fixSin( radians+BANGLE_120 )/2 + FIX_ONE/2) >> 15;
+	o.tri[4] = (axt + SIDE*fixCos( radians-BANGLE_120 )/2 + FIX_ONE/2) >> 15;
+	o.tri[5] = (ayt + SIDE*fixSin( radians-BANGLE_120 )/2 + FIX_ONE/2) >> 15;
+}
+
+template <typename F>
+static unsigned long long run( const std::vector<pos_t> &pos, std::vector<out_t> &out, F update ){
+	unsigned long long start = CYCLES();
+	for( int r=0; r<ROUNDS; r++ )
+		for( int i=0; i<N; i++ )
+			update( pos[i], (r*731) % 36000, out[i] );
+	return (CYCLES() - start) / ((unsigned long long)ROUNDS * N);
+}
+
+int main(){
+	std::vector<pos_t> pos( N );
+	srand( 3 );
+	for( auto &p : pos ){
+		p.relNorth = rand() % 20001 - 10000;
+		p.relEast = rand() % 20001 - 10000;
+		p.relVertical = rand() % 2001 - 1000;
+		p.track = rand() % 360;
+	}
+	std::vector<out_t> a( N ), b( N );
+	for( int mode=0; mode<2; mode++ ){
+		log_scale = !mode;
+		unsigned long long c_legacy = run( pos, a, legacy );
+		unsigned long long c_fixed = run( pos, b, fixed );
+		int dpos = 0, dtri = 0;
+		float ddist = 0;
+		for( int i=0; i<N; i++ ){
+			dpos = std::max( dpos, std::max( abs( a[i].x - b[i].x ), abs( a[i].y - b[i].y ) ) );
+			for( int k=0; k<6; k++ )
+				dtri = std::max( dtri, abs( (a[i].tri[k] - a[i].x) - (b[i].tri[k] - b[i].x) ) );
+			ddist = std::max( ddist, std::max( fabsf( a[i].dist - b[i].dist ), fabsf( a[i].prox - b[i].prox ) ) );
+		}
+		printf( "%s scale: libm %4llu cycles/target, FixMath %4llu cycles/target; max deviation: position %d px, triangle %d px, distance %.4f km\n",
+				log_scale ? "log" : "linear", c_legacy, c_fixed, dpos, dtri, ddist );
+	}
+	return 0;
+}